@@ -0,0 +1,121 @@
+/*
+ * backoff.h - Spin/backoff helpers shared by the slot map implementations.
+ *
+ * backoff is used inside CAS retry loops so that contending threads
+ * don't hammer the same cache line. spin_then_park is used wherever a
+ * thread has to wait for another thread to publish a new value (e.g. a
+ * growing dynamic_slot_map), first spinning for a short while and then
+ * parking on the atomic via C++20 std::atomic::wait. spin_then_wait_until
+ * is its timed counterpart.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace gby
+{
+
+// hint to the cpu that we are in a spin-wait loop
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Exponential backoff for CAS retry loops. Every call to pause() doubles
+// the amount of cpu_relax() calls up until 2^SPIN_LIMIT, after which
+// the thread yields its time slice instead of spinning.
+template<unsigned SPIN_LIMIT = 6, unsigned YIELD_LIMIT = 10>
+class basic_backoff
+{
+public:
+    void pause() noexcept
+    {
+        if (_step <= SPIN_LIMIT)
+        {
+            for (unsigned i = 0; i < (1u << _step); ++i)
+                cpu_relax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+
+        if (_step <= YIELD_LIMIT)
+            ++_step;
+    }
+
+    // true once we are past the spinning phase
+    bool is_parkable() const noexcept { return _step > YIELD_LIMIT; }
+
+    void reset() noexcept { _step = 0; }
+
+private:
+    unsigned _step {};
+};
+
+using backoff = basic_backoff<>;
+
+// Blocks while atomic_ == old_. Spins (with backoff) first, as the value is
+// usually published within a few hundred cycles, and only then parks the
+// thread on the atomic. Whoever changes atomic_ must call notify_all on it.
+template<typename T>
+void spin_then_park(const std::atomic<T>& atomic_, const T old_,
+                    std::memory_order mo_ = std::memory_order_acquire) noexcept
+{
+    backoff bo;
+    while (atomic_.load(mo_) == old_)
+    {
+        if (bo.is_parkable())
+        {
+            atomic_.wait(old_, mo_);
+            return;
+        }
+        bo.pause();
+    }
+}
+
+// Timed version of spin_then_park. std::atomic::wait has no timed overload, so
+// once done spinning we sleep in exponentially growing intervals (capped at
+// MAX_SLEEP) instead of parking. Returns false if deadline_ passed first.
+template<typename T, class Clock, class Duration>
+bool spin_then_wait_until(const std::atomic<T>& atomic_, const T old_,
+                          const std::chrono::time_point<Clock, Duration>& deadline_,
+                          std::memory_order mo_ = std::memory_order_acquire)
+{
+    constexpr std::chrono::microseconds MAX_SLEEP {1000};
+
+    backoff bo;
+    std::chrono::microseconds sleepLen {1};
+    while (atomic_.load(mo_) == old_)
+    {
+        const auto now = Clock::now();
+        if (now >= deadline_)
+            return false;
+
+        if (!bo.is_parkable())
+        {
+            bo.pause();
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::min<typename Clock::duration>(sleepLen, deadline_ - now));
+        sleepLen = std::min(sleepLen*2, MAX_SLEEP);
+    }
+    return true;
+}
+
+} // namespace gby
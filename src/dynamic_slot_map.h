@@ -4,18 +4,37 @@
  * This optimized implementation utilizes elements of lock-free programming
  * to avoid blocking in most scenarios.
  * 
+ * Constructed with the real_time tag it allocates everything up front and
+ * never grows, so that after construction insert, find, erase and iterate_map
+ * don't allocate (for elements that don't allocate themselves); inserting
+ * into a full map throws like the fixed size maps do. try_insert is the
+ * variant for code that can't afford to wait: it makes a bounded amount of
+ * attempts at claiming a slot and returns empty when they are used up or the
+ * map is full, never growing the map or waiting for another thread to.
+ * at() throws, and so allocates, on an out of range key - find() doesn't.
+ * lookup() and insert_nothrow() are the variants for code built without
+ * exceptions: they return a slot_map_result, the value or the reason there
+ * isn't one (see slot_map_result.h).
  */
 
 #pragma once
 
 #include "internal_vector.h"
+#include "backoff.h"
+#include "slot_map_stats.h"
+#include "slot_map_probes.h"
+#include "slot_map_result.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <mutex>
 #include <optional>
+#include <functional>
 #include <assert.h>
 #include <shared_mutex>
+#include <stdexcept>
+#include <type_traits>
 
 
 namespace gby
@@ -59,18 +78,25 @@ public:
             : _capacity{initial_size}
             , _reserve_factor {(reserve_factor > 1) ? reserve_factor : 2}
     {
+        // the slots' buckets are zeroed on allocation, so they're reserved rather than pushed
         _slots.reserve(_capacity + 1); // +1 for sentinel node
         _reverse_array.resize(_capacity + 1); // +1 for sentinel node
         _erase_array.reserve(_capacity + 1); // +1 for sentinel node
 
-        _next_available_slot_index.store(0); // first element of slot container
-        for (slot_index_type slot_idx {}; slot_idx < _capacity; ++slot_idx)
-        {
-            _slots.push_back(std::make_pair(slot_idx+1, key_generation_type{}));
-        }
-        
-        _slots.push_back(std::make_pair(_capacity.load(), key_generation_type{}));
-        _sentinel_last_slot_index.store(_capacity);
+        // slot 0 starts out as the sentinel of the (empty) free list, every
+        // other slot is fresh - handed out by _fresh_slot_index when first used
+        _next_available_slot_index.store(0);
+        _sentinel_last_slot_index.store(0);
+        _fresh_slot_end.store(_capacity + 1);
+    }
+
+    // real-time mode, see the top of the file
+    dynamic_slot_map(real_time_t, slot_index_type capacity)
+            : dynamic_slot_map(capacity)
+    {
+        // the data is otherwise allocated bucket by bucket as it fills up
+        _data.reserve(_capacity + 1);
+        _growable = false;
     }
     
     constexpr key_type insert(const T& value)   { return this->emplace(value);            }
@@ -79,59 +105,72 @@ public:
     template<class... Args> 
     constexpr key_type emplace(Args&&... args) 
     {
-        slot_index_type cur_slot_idx {};
-        do
+        GBY_SLOT_MAP_PROBE(insert_start, this);
+
+        while (true)
         {
-            cur_slot_idx = _next_available_slot_index.load(std::memory_order_acquire);
+            {
+                std::shared_lock lg {_eraseMut, std::defer_lock};
+                _stats.lock(lg);
+                if (const auto acquired_slot_idx = acquireSlot(); likely(acquired_slot_idx.has_value()))
+                    return emplaceInSlot(*acquired_slot_idx, std::forward<Args>(args)...);
+            }
 
-            if (unlikely(cur_slot_idx == _sentinel_last_slot_index.load(std::memory_order_acquire)))
+            if (!_growable)
             {
-                reserve(_reserve_factor*_capacity);
-                while (cur_slot_idx == _sentinel_last_slot_index.load(std::memory_order_acquire))
-                {}
+                GBY_SLOT_MAP_PROBE(insert_end, this, -1);
+                throw_or_abort<std::length_error>("Slot Map is at max capacity.");
             }
+            growOrWait();
         }
-        while (!_next_available_slot_index.compare_exchange_strong(cur_slot_idx, get_index(_slots[cur_slot_idx]))); 
+    }
 
-        slot_type* cur_slot {};
-        {
-            std::shared_lock lg {_eraseMut};
-            slot_index_type cur_value_idx = _data.push_back(std::forward<Args...>(args...));
+    // returns an empty optional if the map is full or max_attempts_ attempts at
+    // claiming a slot failed, in which case value is left untouched
+    constexpr std::optional<key_type> try_insert(const T& value, const size_t max_attempts_ = default_try_attempts)
+    {
+        return tryInsertImpl(value, max_attempts_);
+    }
 
-            cur_slot = &_slots[cur_slot_idx]; 
-            set_index(*cur_slot, cur_value_idx);
-            _reverse_array[cur_value_idx] = cur_slot_idx;            
-        }
-        
-        return {cur_slot_idx, get_generation(*cur_slot).load(std::memory_order_acquire)};       
+    constexpr std::optional<key_type> try_insert(T&& value, const size_t max_attempts_ = default_try_attempts)
+    {
+        return tryInsertImpl(std::move(value), max_attempts_);
     }
 
-    constexpr void reserve(float new_capacity)
+    // try_insert that reports a failure as slot_map_errc::full. It doesn't grow
+    // the map either, and is noexcept: in real-time mode nothing is allocated,
+    // otherwise failing to allocate the element's bucket terminates.
+    constexpr slot_map_result<key_type> insert_nothrow(const T& value, const size_t max_attempts_ = default_try_attempts)
+            noexcept(std::is_nothrow_copy_assignable_v<T>)
     {
-        slot_index_type requested_capacity = static_cast<slot_index_type>(new_capacity);
-        slot_index_type previous_capacity = _capacity.load(std::memory_order_acquire);
-        if (requested_capacity <= previous_capacity)
-            return;
+        if (auto key = tryInsertImpl(value, max_attempts_); likely(key.has_value()))
+            return *key;
+        else
+            return slot_map_errc::full;
+    }
 
-        if (!_capacity.compare_exchange_strong(previous_capacity, requested_capacity))
-            return;
+    constexpr slot_map_result<key_type> insert_nothrow(T&& value, const size_t max_attempts_ = default_try_attempts)
+            noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        if (auto key = tryInsertImpl(std::move(value), max_attempts_); likely(key.has_value()))
+            return *key;
+        else
+            return slot_map_errc::full;
+    }
 
-        // +1 for the sentinel node
-        _data.reserve(requested_capacity+1);
-        _reverse_array.resize(requested_capacity+1);
-        _erase_array.reserve(requested_capacity+1);        
-        _slots.reserve(requested_capacity + 1); 
+    constexpr bool is_real_time() const { return !_growable; }
 
-        for (int i = previous_capacity+1; i < requested_capacity; ++i)
-        {
-            _slots.push_back(std::make_pair(i+1, key_generation_type{}));
-        }
-        _slots.push_back(std::make_pair(requested_capacity, key_generation_type{}));
+    // throws length_error beyond max_capacity()
+    constexpr void reserve(float new_capacity)
+    {
+        if (static_cast<slot_index_type>(new_capacity) <= _capacity.load(std::memory_order_acquire))
+            return;
+        if (unlikely(new_capacity > static_cast<float>(max_capacity())))
+            throw_or_abort<std::length_error>("Slot Map capacity requested is beyond its max capacity.");
 
-        std::shared_lock lg {_eraseMut};
-        auto previousSentinel = _sentinel_last_slot_index.load(std::memory_order_relaxed); 
-        set_index(_slots[previousSentinel], previous_capacity+1);
-        _sentinel_last_slot_index.store(requested_capacity, std::memory_order_relaxed);
+        growth_publisher gp {*this};
+        std::lock_guard lg {_growthMut};
+        reserveImpl(new_capacity);
     }
 
     template<bool Block=false>
@@ -149,8 +188,11 @@ public:
     constexpr void iterate_map(P pred) 
     {
         {
-            std::shared_lock sl {_eraseMut};
+            std::shared_lock sl {_eraseMut, std::defer_lock};
+            _stats.lock(sl);
+            GBY_SLOT_MAP_PROBE(iterate_begin, this);
             _data.iterate_over(pred);
+            GBY_SLOT_MAP_PROBE(iterate_end, this);
         }
         
         drainEraseQueue();
@@ -164,8 +206,40 @@ public:
 
     constexpr size_t size()     const { return _data.size(std::memory_order_acquire); }
     constexpr size_t capacity() const { return _capacity.load(std::memory_order_acquire); }
+
+    // the most the internal vectors can hold, less the sentinel
+    static constexpr size_t max_capacity()
+    {
+        return std::min({container_type::max_size(),
+                         decltype(_slots)::max_size(),
+                         decltype(_erase_array)::max_size()}) - 1;
+    }
     constexpr bool   empty()    const { return size() == 0; }
 
+    // the internal_vectors' buckets grow exponentially, whatever they hold
+    // beyond the map's capacity (+1 for the sentinel) is reported as slack
+    memory_usage_breakdown memory_usage() const
+    {
+        const size_t needed = capacity() + 1;
+        memory_usage_breakdown usage {};
+
+        auto split = [&](const auto& vec_, size_t& component_)
+        {
+            using element_type = typename std::decay_t<decltype(vec_)>::value_type;
+            const size_t used = std::min(vec_.capacity(), needed);
+            component_          += used * sizeof(element_type);
+            usage.bucket_slack  += (vec_.capacity() - used) * sizeof(element_type);
+        };
+        split(_slots, usage.slots);
+        split(_data, usage.data);
+        split(_erase_array, usage.erase_queue);
+        usage.reverse_array = _reverse_array.capacity() * sizeof(slot_index_type);
+        return usage;
+    }
+
+    // all zeros unless built with GBY_SLOT_MAP_STATS, see slot_map_stats.h
+    slot_map_stats stats() const { return _stats.snapshot(); }
+
     constexpr reference operator[](const key_type& key)              
     { 
         return find_unchecked(key);
@@ -178,18 +252,16 @@ public:
 
     constexpr std::optional<std::reference_wrapper<value_type>> at(const key_type& key)
     {
-        if (const auto&[idx,gen] = key; idx >= size())
-            throw std::out_of_range("Index " + std::to_string(idx) + 
-                    " is larger than Slot Map size of " + std::to_string(size()));
+        if (const auto&[idx,gen] = key; unlikely(static_cast<size_t>(idx) > capacity()))
+            throw_or_abort<std::out_of_range>("Slot Map key index is out of range.");
         
         return find(key);
     }
 
     constexpr std::optional<std::reference_wrapper<const value_type>> at(const key_type& key) const
     {
-        if (const auto&[idx, gen] = key; idx >= size())
-            throw std::out_of_range("Index " + std::to_string(idx) + 
-                    " is larger than Slot Map size of " + std::to_string(size()));
+        if (const auto&[idx, gen] = key; unlikely(static_cast<size_t>(idx) > capacity()))
+            throw_or_abort<std::out_of_range>("Slot Map key index is out of range.");
         
         return find(key);
     }
@@ -213,6 +285,24 @@ public:
             return {};
     }
 
+    // find() that tells why it found nothing: slot_map_errc::out_of_range if the
+    // key's index is past the slots, slot_map_errc::stale_key if its element is gone
+    constexpr slot_map_result<std::reference_wrapper<value_type>> lookup(const key_type& key) noexcept
+    {
+        if (auto slot = get_slot(key); likely(slot.has_value()))
+            return std::ref(_data[get_index<slot_type>(*slot)]);
+        else
+            return slot.error();
+    }
+
+    constexpr slot_map_result<std::reference_wrapper<const value_type>> lookup(const key_type& key) const noexcept
+    {
+        if (auto slot = get_slot(key); likely(slot.has_value()))
+            return std::cref(_data[get_index<slot_type>(*slot)]);
+        else
+            return slot.error();
+    }
+
     constexpr reference find_unchecked(const key_type& key) 
     {
         const auto& slot {_slots[get_index<key_type>(key)]};
@@ -225,12 +315,28 @@ public:
         return _data[get_index<slot_type>(slot)];
     }
 
+    // erase without draining: the element stays in place until the next drain
+    bool addToEraseQueue(const key_type &key)
+    {
+        if (validate_and_increment_slot(key))
+        {
+            const size_t idx = _erase_array.claim_back();
+            publish_erase_entry(_erase_array[idx], get_index(key));
+            _stats.erase_queued(idx+1);
+            GBY_SLOT_MAP_PROBE(erase_enqueue, this, get_index(key), idx+1);
+            return true;
+        }
+        return false;
+    }
+
     template<bool Block=false>
     void drainEraseQueue()
     {
+        _stats.drain_attempted();
         if constexpr (Block)
         {
-            std::unique_lock ul {_eraseMut};
+            std::unique_lock ul {_eraseMut, std::defer_lock};
+            _stats.lock(ul);
             drainEraseQueueImpl();
         }
         else
@@ -246,77 +352,58 @@ public:
 private:
    constexpr bool validate_and_increment_slot(const key_type &key) noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > capacity()))
+            return false;
 
-            auto &slot = _slots[idx];
+        auto &slot = _slots[idx];
 
-            key_generation_type genCpy = gen;
-            auto& slotGen = const_cast<slot_generation_type&>(get_generation(slot));
-            if (slotGen.compare_exchange_strong(genCpy, genCpy+1))
-                return true;
-        }
-        catch(const std::out_of_range &e) 
-        {}
-        
-        return false;
+        key_generation_type genCpy = gen;
+        auto& slotGen = const_cast<slot_generation_type&>(get_generation(slot));
+        return slotGen.compare_exchange_strong(genCpy, genCpy+1);
     }
 
-    constexpr std::optional<std::reference_wrapper<const slot_type>> get_slot(const key_type &key) const noexcept
+    constexpr slot_map_result<std::reference_wrapper<const slot_type>> get_slot(const key_type &key) const noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > capacity()))
+            return slot_map_errc::out_of_range;
 
-            const auto &slot = _slots[idx];
-            if (get_generation(slot).load(std::memory_order_acquire) == gen)
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
-        
-        return {};
+        const auto &slot = _slots[idx];
+        if (get_generation(slot).load(std::memory_order_acquire) == gen)
+            return std::ref(slot);
+
+        return slot_map_errc::stale_key;
     }
 
-    constexpr std::optional<std::reference_wrapper<slot_type>> get_slot(const key_type &key) noexcept
+    constexpr slot_map_result<std::reference_wrapper<slot_type>> get_slot(const key_type &key) noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
-
-            auto &slot = _slots[idx];
-            if (get_generation(slot).load(std::memory_order_relaxed) == gen)
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > capacity()))
+            return slot_map_errc::out_of_range;
 
-        return {};
-    }
+        auto &slot = _slots[idx];
+        if (get_generation(slot).load(std::memory_order_relaxed) == gen)
+            return std::ref(slot);
 
-    bool addToEraseQueue(const key_type &key)
-    {
-        if (validate_and_increment_slot(key))
-        {
-            _erase_array.push_back(get_index(key));
-            return true;
-        }
-        return false;
+        return slot_map_errc::stale_key;
     }
 
     // should only ever be called by drainEraseQueue - don't call this directly.
     void drainEraseQueueImpl()
     {
+        GBY_SLOT_MAP_PROBE(drain_begin, this);
+        trace_span span {"drain", "elements"};
+
         size_t cur_erase_array_length {};
         size_t erase_idx {};
-        do
+        while (true)
         {
             cur_erase_array_length = _erase_array.size();
 
             for ( ; erase_idx < cur_erase_array_length; ++erase_idx)
             {
-                const size_t slot_to_erase_idx = _erase_array[erase_idx];
+                const size_t slot_to_erase_idx = take_erase_entry(_erase_array[erase_idx]);
                 slot_type &slot_to_erase = _slots[slot_to_erase_idx];
                 size_t data_idx_to_free = get_index(slot_to_erase);
 
@@ -334,26 +421,206 @@ private:
                 set_index(_slots[previous_sentinel], slot_to_erase_idx);
                 _sentinel_last_slot_index.store(slot_to_erase_idx, std::memory_order_release);
             }
+
+            if (_erase_array.clearIfSizeEquals(erase_idx))
+                break;
+            _stats.cas_failure(cas_site::drain);
         }
-        while (!_erase_array.clearIfSizeEquals(erase_idx));
+        _stats.drained(erase_idx);
+        span.set_arg(erase_idx);
+        GBY_SLOT_MAP_PROBE(drain_end, this, erase_idx);
     }
 
+    // places the element in the claimed slot cur_slot_idx. Must be called with
+    // _eraseMut held shared, the same hold the slot was acquired under.
+    template<class... Args>
+    key_type emplaceInSlot(const slot_index_type cur_slot_idx, Args&&... args)
+    {
+        slot_index_type cur_value_idx = _data.push_back(std::forward<Args...>(args...));
+
+        slot_type& cur_slot = _slots[cur_slot_idx]; 
+        set_index(cur_slot, cur_value_idx);
+        _reverse_array[cur_value_idx] = cur_slot_idx;            
+
+        GBY_SLOT_MAP_PROBE(insert_end, this, cur_slot_idx);
+        return {cur_slot_idx, get_generation(cur_slot).load(std::memory_order_acquire)};       
+    }
+
+    template<class V>
+    std::optional<key_type> tryInsertImpl(V&& value, const size_t max_attempts_)
+    {
+        GBY_SLOT_MAP_PROBE(insert_start, this);
+
+        std::shared_lock lg {_eraseMut, std::defer_lock};
+        _stats.lock(lg);
+        const auto acquired_slot_idx = acquireSlot(max_attempts_);
+        if (unlikely(!acquired_slot_idx))
+        {
+            GBY_SLOT_MAP_PROBE(insert_end, this, -1);
+            return {};
+        }
+        return emplaceInSlot(*acquired_slot_idx, std::forward<V>(value));
+    }
+
+    // a recycled slot off the free list if there is one (it's still warm in
+    // cache), otherwise the next fresh one. Empty if the map needs to grow, or
+    // once max_attempts_ compare-exchanges in a row lost to other inserters.
+    // Must be called with _eraseMut held shared: the drains are what push the
+    // slots back onto the free list, and one running between reading the
+    // head's link and the compare-exchange could bring the head back with
+    // another link (ABA), handing out a slot that's in use.
+    std::optional<slot_index_type> acquireSlot(const size_t max_attempts_ = unbounded_attempts)
+    {
+        backoff bo;
+        for (size_t attempt = 1; ; ++attempt)
+        {
+            slot_index_type cur_slot_idx = _next_available_slot_index.load(std::memory_order_acquire);
+            if (cur_slot_idx != _sentinel_last_slot_index.load(std::memory_order_acquire))
+            {
+                if (_next_available_slot_index.compare_exchange_strong(cur_slot_idx, get_index(_slots[cur_slot_idx])))
+                    return cur_slot_idx;
+                _stats.cas_failure(cas_site::free_list);
+                GBY_SLOT_MAP_PROBE(free_list_cas_retry, this);
+            }
+            else
+            {
+                // fresh slots are zeroed and never linked, so claiming one is all it takes
+                slot_index_type fresh_slot_idx = _fresh_slot_index.load(std::memory_order_relaxed);
+                if (unlikely(fresh_slot_idx >= _fresh_slot_end.load(std::memory_order_acquire)))
+                    return {};
+
+                if (_fresh_slot_index.compare_exchange_strong(fresh_slot_idx, fresh_slot_idx+1, std::memory_order_relaxed))
+                    return fresh_slot_idx;
+                _stats.cas_failure(cas_site::fresh_slot);
+            }
+
+            if (attempt == max_attempts_)
+                return {};
+            bo.pause();
+        }
+    }
+
+    bool hasFreeSlot() const
+    {
+        return _next_available_slot_index.load(std::memory_order_acquire) != _sentinel_last_slot_index.load(std::memory_order_acquire) ||
+               _fresh_slot_index.load(std::memory_order_relaxed) < _fresh_slot_end.load(std::memory_order_acquire);
+    }
+
+    // called once there are no free slots left. Only one thread grows the map,
+    // the rest wait (spin, then park) until it is done.
+    void growOrWait()
+    {
+        const auto growth_epoch = _growth_epoch.load(std::memory_order_acquire);
+
+        // declared before the lock so that it publishes after the unlock,
+        // even if growing throws - or the waiting inserters would never wake
+        growth_publisher gp {*this};
+        std::unique_lock gl {_growthMut, std::try_to_lock};
+        if (!gl.owns_lock())
+        {
+            gp.dismiss();
+            spin_then_park(_growth_epoch, growth_epoch);
+            return;
+        }
+
+        // a drain or another grower might have freed up slots by now
+        if (hasFreeSlot())
+            return;
+
+        const size_t cur_capacity = _capacity.load(std::memory_order_acquire);
+        if (unlikely(cur_capacity >= max_capacity()))
+            throw_or_abort<std::length_error>("Slot Map is at max capacity.");
+
+        reserveImpl(_reserve_factor*cur_capacity);
+    }
+
+    // should only be called while holding _growthMut
+    void reserveImpl(float new_capacity)
+    {
+        slot_index_type requested_capacity = static_cast<slot_index_type>(std::min(new_capacity, static_cast<float>(max_capacity())));
+        slot_index_type previous_capacity = _capacity.load(std::memory_order_acquire);
+        if (requested_capacity <= previous_capacity)
+            return;
+
+        GBY_SLOT_MAP_PROBE(grow_begin, this, previous_capacity, requested_capacity);
+        trace_span span {"grow", "capacity"};
+        span.set_arg(requested_capacity);
+
+        // +1 for the sentinel node
+        _data.reserve(requested_capacity+1);
+        _erase_array.reserve(requested_capacity+1);        
+        _slots.reserve(requested_capacity + 1); 
+
+        // resizing may reallocate the reverse array, so we can't have
+        // anyone inserting or draining while it happens.
+        std::unique_lock ul {_eraseMut, std::defer_lock};
+        _stats.lock(ul);
+        _reverse_array.resize(requested_capacity+1);
+
+        // the new slots are fresh, right after the previous ones
+        _capacity.store(requested_capacity, std::memory_order_release);
+        _fresh_slot_end.store(requested_capacity+1, std::memory_order_release);
+        _stats.grew();
+        GBY_SLOT_MAP_PROBE(grow_end, this, requested_capacity);
+    }
+
+    // must be called after releasing _growthMut, so that a thread which failed
+    // to acquire it is guaranteed to see the epoch change.
+    void publishGrowth()
+    {
+        _growth_epoch.fetch_add(1, std::memory_order_acq_rel);
+        _growth_epoch.notify_all();
+    }
+
+    // publishes the growth attempt on scope exit, however it ended
+    class growth_publisher
+    {
+    public:
+        explicit growth_publisher(dynamic_slot_map& map_) : _map {&map_} {}
+        ~growth_publisher() { if (_map) _map->publishGrowth(); }
+
+        growth_publisher(const growth_publisher&) = delete;
+        growth_publisher& operator=(const growth_publisher&) = delete;
+
+        void dismiss() { _map = nullptr; }
+
+    private:
+        dynamic_slot_map* _map;
+    };
+
     gby::internal_vector<slot_type> _slots;
     container_type                  _data;
     std::vector<slot_index_type> _reverse_array;    
 
+    // free list of the recycled slots
     std::atomic<key_index_type> _next_available_slot_index;
     std::atomic<key_index_type> _sentinel_last_slot_index;
 
+    // high-water mark of the slots ever used: the slots from here to
+    // _fresh_slot_end (one past the capacity) are fresh
+    std::atomic<key_index_type> _fresh_slot_index {1};
+    std::atomic<key_index_type> _fresh_slot_end;
+
     std::atomic<slot_index_type> _capacity;
 
+    // serializes growth. _growth_epoch is bumped after every growth attempt
+    // and is what inserters wait on while another thread grows the map.
+    std::mutex            _growthMut;
+    std::atomic<uint32_t> _growth_epoch {};
+
     float _reserve_factor;
 
+    // false in real-time mode
+    bool _growable {true};
+
     // stack used to store elements to be deleted.
     gby::internal_vector<slot_index_type> _erase_array;
 
     // enforces that we can't iterate & delete at the same time
     std::shared_mutex _eraseMut;
+
+    using cas_site = slot_map_counters::cas_site;
+    [[no_unique_address]] slot_map_counters _stats;
 };
 
 } // namespace gby
@@ -0,0 +1,426 @@
+/*
+ * instrumented_slot_map.h - Latency instrumentation for any of the slot maps.
+ *
+ * instrumented_slot_map<Map> owns a Map and has the same API: every call is
+ * forwarded to the map, and the inserts, erases, lookups and iterations are
+ * timed on the way. Swapping the map's type for instrumented_slot_map<Map>
+ * is all it takes to measure an application's use of the map, the call
+ * sites stay the same.
+ *
+ * Operations are timed with the time stamp counter (rdtsc) where there is
+ * one, steady_clock elsewhere, and recorded in nanoseconds into log-linear
+ * histograms (latency_histogram.h). Every thread records into histograms of
+ * its own, so recording never contends between threads; latencies() merges
+ * them on demand, and may be called while the map is in use. Calls that
+ * throw aren't recorded.
+ *
+ * The merged histograms can be exported as JSON, or in the Prometheus text
+ * format - write_prometheus_file() replaces the file atomically, for a
+ * scraper (e.g. node_exporter's textfile collector) reading it at any time.
+ */
+
+#pragma once
+
+#include "latency_histogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace gby
+{
+
+namespace detail
+{
+
+// time stamp counter ticks, calibrated once against steady_clock
+class tick_clock
+{
+public:
+    static uint64_t now() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    static uint64_t to_ns(const uint64_t ticks_) noexcept
+    {
+        return static_cast<uint64_t>(ticks_ * ns_per_tick());
+    }
+
+    static double ns_per_tick()
+    {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+private:
+    static double calibrate()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        using namespace std::chrono;
+
+        const auto     start_time  = steady_clock::now();
+        const uint64_t start_ticks = now();
+        while (steady_clock::now() - start_time < milliseconds{10})
+            ;
+        const uint64_t ticks   = now() - start_ticks;
+        const auto     elapsed = duration_cast<nanoseconds>(steady_clock::now() - start_time);
+        return ticks == 0 ? 1 : static_cast<double>(elapsed.count()) / ticks;
+#else
+        using period = std::chrono::steady_clock::period;
+        return 1e9 * period::num / period::den;
+#endif
+    }
+};
+
+} // namespace detail
+
+template<class Map>
+class instrumented_slot_map
+{
+public:
+    using map_type        = Map;
+    using key_type        = typename Map::key_type;
+    using value_type      = typename Map::value_type;
+    using size_type       = typename Map::size_type;
+    using reference       = typename Map::reference;
+    using const_reference = typename Map::const_reference;
+
+    enum class operation
+    {
+        insert,   // insert, emplace, their try_/_wait variants and insert_nothrow
+        erase,
+        find,     // find, lookup, at, operator[] and find_unchecked
+        iterate
+    };
+
+    static constexpr size_t OPERATIONS = 4;
+
+    static constexpr std::array<std::string_view, OPERATIONS> operation_names {"insert", "erase", "find", "iterate"};
+
+    template<class... Args>
+    explicit instrumented_slot_map(Args&&... args)
+            : _map (std::forward<Args>(args)...)
+    {
+        detail::tick_clock::ns_per_tick();
+    }
+
+    instrumented_slot_map(const instrumented_slot_map&) = delete;
+    instrumented_slot_map& operator=(const instrumented_slot_map&) = delete;
+
+    /*
+     * The timed operations.
+     */
+
+    template<class... Args>
+    decltype(auto) insert(Args&&... args) requires requires (Map& m) { m.insert(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.insert(std::forward<Args>(args)...); });
+    }
+
+    template<class... Args>
+    decltype(auto) emplace(Args&&... args) requires requires (Map& m) { m.emplace(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.emplace(std::forward<Args>(args)...); });
+    }
+
+    template<class... Args>
+    decltype(auto) try_emplace(Args&&... args) requires requires (Map& m) { m.try_emplace(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.try_emplace(std::forward<Args>(args)...); });
+    }
+
+    template<class... Args>
+    decltype(auto) try_insert(Args&&... args) requires requires (Map& m) { m.try_insert(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.try_insert(std::forward<Args>(args)...); });
+    }
+
+    template<class... Args>
+    decltype(auto) insert_wait(Args&&... args) requires requires (Map& m) { m.insert_wait(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.insert_wait(std::forward<Args>(args)...); });
+    }
+
+    template<class... Args>
+    decltype(auto) try_insert_for(Args&&... args) requires requires (Map& m) { m.try_insert_for(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.try_insert_for(std::forward<Args>(args)...); });
+    }
+
+    template<class... Args>
+    decltype(auto) insert_nothrow(Args&&... args) requires requires (Map& m) { m.insert_nothrow(std::forward<Args>(args)...); }
+    {
+        return timed(operation::insert, [&]() -> decltype(auto) { return _map.insert_nothrow(std::forward<Args>(args)...); });
+    }
+
+    // Params are the map's own template arguments to erase, if any (e.g. erase<true>(key))
+    template<auto... Params, class... Args>
+    decltype(auto) erase(Args&&... args)
+    {
+        return timed(operation::erase, [&]() -> decltype(auto) {
+            if constexpr (sizeof...(Params) == 0)
+                return _map.erase(std::forward<Args>(args)...);
+            else
+                return _map.template erase<Params...>(std::forward<Args>(args)...);
+        });
+    }
+
+    template<class K> decltype(auto) find(const K& key)       { return timed(operation::find, [&]() -> decltype(auto) { return _map.find(key); }); }
+    template<class K> decltype(auto) find(const K& key) const { return timed(operation::find, [&]() -> decltype(auto) { return _map.find(key); }); }
+
+    template<class K> decltype(auto) lookup(const K& key)       { return timed(operation::find, [&]() -> decltype(auto) { return _map.lookup(key); }); }
+    template<class K> decltype(auto) lookup(const K& key) const { return timed(operation::find, [&]() -> decltype(auto) { return _map.lookup(key); }); }
+
+    template<class K> decltype(auto) at(const K& key)       { return timed(operation::find, [&]() -> decltype(auto) { return _map.at(key); }); }
+    template<class K> decltype(auto) at(const K& key) const { return timed(operation::find, [&]() -> decltype(auto) { return _map.at(key); }); }
+
+    template<class K> decltype(auto) operator[](const K& key)       { return timed(operation::find, [&]() -> decltype(auto) { return _map[key]; }); }
+    template<class K> decltype(auto) operator[](const K& key) const { return timed(operation::find, [&]() -> decltype(auto) { return _map[key]; }); }
+
+    template<class K> decltype(auto) find_unchecked(const K& key)       { return timed(operation::find, [&]() -> decltype(auto) { return _map.find_unchecked(key); }); }
+    template<class K> decltype(auto) find_unchecked(const K& key) const { return timed(operation::find, [&]() -> decltype(auto) { return _map.find_unchecked(key); }); }
+
+    template<class P>
+    void iterate_map(P&& pred)
+    {
+        timed(operation::iterate, [&] { _map.iterate_map(std::forward<P>(pred)); });
+    }
+
+    /*
+     * Passed through untimed.
+     */
+
+    decltype(auto) size()     const requires requires (const Map& m) { m.size(); }     { return _map.size();     }
+    decltype(auto) capacity() const requires requires (const Map& m) { m.capacity(); } { return _map.capacity(); }
+    decltype(auto) empty()    const requires requires (const Map& m) { m.empty(); }    { return _map.empty();    }
+
+    // unsynchronized in the maps that have them, as they are there
+    decltype(auto) begin()       requires requires (Map& m)       { m.begin(); } { return _map.begin(); }
+    decltype(auto) begin() const requires requires (const Map& m) { m.begin(); } { return _map.begin(); }
+    decltype(auto) end()         requires requires (Map& m)       { m.end(); }   { return _map.end();   }
+    decltype(auto) end()   const requires requires (const Map& m) { m.end(); }   { return _map.end();   }
+
+    template<class... Args>
+    decltype(auto) reserve(Args&&... args) requires requires (Map& m) { m.reserve(std::forward<Args>(args)...); }
+    {
+        return _map.reserve(std::forward<Args>(args)...);
+    }
+
+    decltype(auto) memory_usage() const requires requires (const Map& m) { m.memory_usage(); } { return _map.memory_usage(); }
+    decltype(auto) stats()        const requires requires (const Map& m) { m.stats(); }        { return _map.stats();        }
+
+    // the wrapped map, for anything else - calls made through it aren't timed
+    Map&       base()       { return _map; }
+    const Map& base() const { return _map; }
+
+    /*
+     * The latencies, in nanoseconds.
+     */
+
+    // op_'s latencies merged over all threads so far
+    latency_histogram latencies(const operation op_) const
+    {
+        latency_histogram merged {};
+        std::lock_guard lg {_recorders_lock};
+        for (const auto& [thread, rec] : _recorders)
+            merged.merge(rec->histograms[static_cast<size_t>(op_)].snapshot());
+        return merged;
+    }
+
+    // {"map": name_, "operations": {"insert": {"count": .., "sum_ns": .., "p50_ns": .., ...,
+    //  "buckets": [[upper bound ns, count], ...]}, ...}}, only the nonempty buckets are listed
+    void write_json(std::ostream& os_, const std::string_view name_ = "slot_map") const
+    {
+        os_ << "{\"map\": \"" << escaped(name_) << "\", \"operations\": {";
+        for (size_t op = 0; op < OPERATIONS; ++op)
+        {
+            const auto histogram = latencies(static_cast<operation>(op));
+
+            os_ << (op == 0 ? "" : ", ") << '"' << operation_names[op] << "\": {"
+                << "\"count\": "     << histogram.count()
+                << ", \"sum_ns\": "  << histogram.sum()
+                << ", \"p50_ns\": "  << histogram.percentile(50)
+                << ", \"p90_ns\": "  << histogram.percentile(90)
+                << ", \"p99_ns\": "  << histogram.percentile(99)
+                << ", \"p999_ns\": " << histogram.percentile(99.9)
+                << ", \"max_ns\": "  << histogram.max()
+                << ", \"buckets\": [";
+
+            bool first {true};
+            for (size_t i = 0; i < latency_histogram::BUCKETS; ++i)
+            {
+                if (const auto count = histogram.bucket_count(i); count != 0)
+                {
+                    os_ << (first ? "" : ", ") << '[' << latency_histogram::bucket_upper_bound(i) << ", " << count << ']';
+                    first = false;
+                }
+            }
+            os_ << "]}";
+        }
+        os_ << "}}\n";
+    }
+
+    // one histogram metric, gby_slot_map_operation_latency_seconds, labeled by
+    // map and operation, with power of 2 buckets from 16ns to ~69s. Set
+    // with_header_ to false for all but the first map written to the same stream.
+    void write_prometheus(std::ostream& os_, const std::string_view name_ = "slot_map", const bool with_header_ = true) const
+    {
+        constexpr std::string_view metric = "gby_slot_map_operation_latency_seconds";
+
+        if (with_header_)
+        {
+            os_ << "# HELP " << metric << " Latency of slot map operations.\n"
+                << "# TYPE " << metric << " histogram\n";
+        }
+
+        for (size_t op = 0; op < OPERATIONS; ++op)
+        {
+            const auto histogram = latencies(static_cast<operation>(op));
+            const auto labels    = "map=\"" + escaped(name_) + "\",operation=\"" + std::string{operation_names[op]} + '"';
+
+            for (unsigned power = 4; power <= 36; ++power)
+            {
+                const uint64_t bound = uint64_t{1} << power;
+                os_ << metric << "_bucket{" << labels << ",le=\"" << bound * 1e-9 << "\"} "
+                    << histogram.count_at_most(bound) << '\n';
+            }
+            os_ << metric << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count() << '\n'
+                << metric << "_sum{"    << labels << "} " << histogram.sum() * 1e-9 << '\n'
+                << metric << "_count{"  << labels << "} " << histogram.count() << '\n';
+        }
+    }
+
+    // writes the Prometheus text to a temporary file next to path_ and renames
+    // it over path_, so a reader never sees a partly written file
+    bool write_prometheus_file(const std::filesystem::path& path_, const std::string_view name_ = "slot_map") const
+    {
+        auto tmp_path = path_;
+        tmp_path += ".tmp";
+
+        {
+            std::ofstream file {tmp_path, std::ios::trunc};
+            if (!file)
+                return false;
+            write_prometheus(file, name_);
+            if (!file.flush())
+                return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path_, ec);
+        return !ec;
+    }
+
+private:
+    // a thread's histograms. Owned by the map, so they outlive the thread and
+    // the thread's records are kept after it is gone.
+    struct alignas(64) recorder
+    {
+        std::array<atomic_latency_histogram, OPERATIONS> histograms {};
+    };
+
+    template<class Fnc>
+    decltype(auto) timed(const operation op_, Fnc&& fnc_) const
+    {
+        auto& rec = current_recorder();
+        const uint64_t start = detail::tick_clock::now();
+
+        if constexpr (std::is_void_v<decltype(fnc_())>)
+        {
+            fnc_();
+            rec.histograms[static_cast<size_t>(op_)].record(detail::tick_clock::to_ns(detail::tick_clock::now() - start));
+        }
+        else
+        {
+            decltype(auto) result = fnc_();
+            rec.histograms[static_cast<size_t>(op_)].record(detail::tick_clock::to_ns(detail::tick_clock::now() - start));
+            return result;
+        }
+    }
+
+    // The calling thread's recorder, found through a small thread local cache
+    // of (map id, recorder) so that the registry's lock is only taken on a
+    // thread's first operation on a map. Ids are never reused, so entries of
+    // destroyed maps are never matched, and they are dropped wholesale once the
+    // cache fills up - the registry still has the thread's recorder.
+    recorder& current_recorder() const
+    {
+        struct cache_entry
+        {
+            uint64_t  map_id;
+            recorder* rec;
+        };
+        constexpr size_t CACHE_SIZE = 16;
+        thread_local std::vector<cache_entry> cache;
+
+        for (const auto& entry : cache)
+            if (entry.map_id == _id)
+                return *entry.rec;
+
+        recorder* rec {};
+        {
+            std::lock_guard lg {_recorders_lock};
+            auto& slot = _recorders[std::this_thread::get_id()];
+            if (!slot)
+                slot = std::make_unique<recorder>();
+            rec = slot.get();
+        }
+
+        if (cache.size() == CACHE_SIZE)
+            cache.clear();
+        cache.push_back({_id, rec});
+        return *rec;
+    }
+
+    static std::string escaped(const std::string_view str_)
+    {
+        std::string out;
+        for (const char c : str_)
+        {
+            if (c == '\\' || c == '"')
+                out += '\\';
+            if (c == '\n')
+                out += "\\n";
+            else
+                out += c;
+        }
+        return out;
+    }
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> ids {};
+        return ids.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Map _map;
+
+    const uint64_t _id {next_id()};
+    mutable std::mutex _recorders_lock;
+    mutable std::unordered_map<std::thread::id, std::unique_ptr<recorder>> _recorders;
+};
+
+} // namespace gby
@@ -19,6 +19,7 @@
 #include <concepts>
 #include <atomic>
 #include <array>
+#include <stdexcept>
 
 #include "utils.h"
 
@@ -104,7 +105,7 @@ public:
         return at(idx_);
     }
 
-    constexpr const size_type push_back(const value_type& val_)
+    constexpr size_type push_back(const value_type& val_)
     {
         const size_type index = _size.fetch_add(1, std::memory_order_acq_rel);
         const auto [bucket, b_idx] = get_location(index);
@@ -138,6 +139,34 @@ public:
         return index;        
     }
 
+    constexpr size_type push_back(value_type&& val_)
+    {
+        if constexpr (is_atomic<value_type> || is_pair_atomic<value_type>)
+        {
+            return push_back(std::as_const(val_));
+        }
+        else
+        {
+            const size_type index = _size.fetch_add(1, std::memory_order_acq_rel);
+            const auto [bucket, b_idx] = get_location(index);
+            if (_bucketArr[bucket].first == 0)
+                allocate_bucket(bucket);
+
+            _bucketArr[bucket].second.load(std::memory_order_acquire)[b_idx] = std::move(val_);
+            return index;
+        }
+    }
+
+    // claims the next element and returns its index, for the caller to write
+    // itself (e.g. atomically)
+    constexpr size_type claim_back()
+    {
+        const size_type index = _size.fetch_add(1, std::memory_order_acq_rel);
+        if (const auto [bucket, b_idx] = get_location(index); _bucketArr[bucket].first == 0)
+            allocate_bucket(bucket);
+        return index;
+    }
+
     template<bool decrementSize=false>
     constexpr bool update(const size_type idx_, const value_type& val_)
     {
@@ -167,7 +196,7 @@ public:
             cur_size = _size.load(std::memory_order_acquire);
             if (unlikely(cur_size == 0))
             {
-                throw std::out_of_range("internal vector is empty!");
+                throw_or_abort<std::out_of_range>("internal vector is empty!");
             }
 
             element  = at(cur_size-1);
@@ -195,6 +224,16 @@ public:
         return _capacity;
     }
 
+    // the elements all the buckets together hold - reserving more throws
+    static constexpr size_type max_size()
+    {
+        size_type total {};
+        size_type bucket_size {FIRST_BUCKET_SIZE};
+        for (size_t i = 0; i < BUCKET_COUNT; ++i, bucket_size *= FIRST_BUCKET_SIZE)
+            total += bucket_size;
+        return total;
+    }
+
     constexpr size_t bucket_count() const
     {
         return _usedBucketCount.load(std::memory_order_acquire) + 1; // +1 because we are starting at 0
@@ -236,6 +275,13 @@ private:
         return arr[idx];
     }
 
+    constexpr const value_type& at(const size_type i_) const
+    {
+        auto [bucket, idx] = get_location(i_); 
+        const T* arr       = _bucketArr[bucket].second.load(std::memory_order_acquire); 
+        return arr[idx];
+    }
+
     constexpr size_t highest_bit(const size_type val_) const noexcept
     {
         assert(val_ != 0);
@@ -247,7 +293,7 @@ private:
         value_type* L_VALUE_NULLPTR = nullptr;
 
         if (bucket_ >= BUCKET_COUNT)
-            throw std::length_error("Lock-free array reached max bucket size."); 
+            throw_or_abort<std::length_error>("Lock-free array reached max bucket size.");
         
         const size_t bucketSize = round(pow(FIRST_BUCKET_SIZE, bucket_+1));
         T* newMemBlock = new T[bucketSize]();
@@ -0,0 +1,155 @@
+/*
+ * latency_histogram.h - Log-linear latency histograms.
+ *
+ * Every power of 2 is split into SUB_BUCKETS linear buckets, so values are
+ * kept with a relative error below 1/SUB_BUCKETS while the histogram stays a
+ * fixed, small array that is cheap to record into.
+ *
+ * latency_histogram isn't thread safe - every thread records into its own
+ * and they are merged after. atomic_latency_histogram is recorded into by a
+ * single thread while others may take snapshots of it at any time.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace gby
+{
+
+class latency_histogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr unsigned SUB_BUCKETS     = 1u << SUB_BUCKET_BITS;
+    static constexpr size_t   BUCKETS         = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(const uint64_t value_)
+    {
+        ++_counts[bucket_index(value_)];
+        ++_total_count;
+        _sum += value_;
+        _max = std::max(_max, value_);
+    }
+
+    void merge(const latency_histogram& other_)
+    {
+        for (size_t i = 0; i < _counts.size(); ++i)
+            _counts[i] += other_._counts[i];
+        _total_count += other_._total_count;
+        _sum += other_._sum;
+        _max = std::max(_max, other_._max);
+    }
+
+    // upper bound of the bucket holding the percentile_ (0-100) value
+    uint64_t percentile(const double percentile_) const
+    {
+        if (_total_count == 0)
+            return 0;
+
+        const auto rank = static_cast<uint64_t>(percentile_ / 100 * (_total_count - 1)) + 1;
+        uint64_t seen {};
+        for (size_t i = 0; i < _counts.size(); ++i)
+        {
+            seen += _counts[i];
+            if (seen >= rank)
+                return std::min(bucket_upper_bound(i), _max);
+        }
+        return _max;
+    }
+
+    // amount of values at most value_, counted by whole buckets
+    uint64_t count_at_most(const uint64_t value_) const
+    {
+        uint64_t count {};
+        for (size_t i = 0; i < _counts.size() && bucket_upper_bound(i) <= value_; ++i)
+            count += _counts[i];
+        return count;
+    }
+
+    uint64_t count() const { return _total_count; }
+    uint64_t sum()   const { return _sum; }
+    uint64_t max()   const { return _max; }
+
+    // amount of values in bucket idx_
+    uint64_t bucket_count(const size_t idx_) const { return _counts[idx_]; }
+
+    // values below SUB_BUCKETS get a bucket each, above that bucket
+    // (msb - SUB_BUCKET_BITS + 1) is split by the SUB_BUCKET_BITS following the msb
+    static size_t bucket_index(const uint64_t value_)
+    {
+        if (value_ < SUB_BUCKETS)
+            return value_;
+
+        const unsigned msb   = std::bit_width(value_) - 1;
+        const unsigned shift = msb - SUB_BUCKET_BITS;
+        const size_t   sub   = (value_ >> shift) & (SUB_BUCKETS - 1);
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t bucket_upper_bound(const size_t idx_)
+    {
+        if (idx_ < SUB_BUCKETS)
+            return idx_;
+
+        const unsigned shift = idx_ / SUB_BUCKETS - 1;
+        const uint64_t sub   = idx_ % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+private:
+    friend class atomic_latency_histogram;
+
+    std::array<uint64_t, BUCKETS> _counts {};
+    uint64_t _total_count {};
+    uint64_t _sum {};
+    uint64_t _max {};
+};
+
+// Single writer histogram that can be read while it is being recorded into.
+// The writer only does relaxed loads and stores - no read-modify-writes - so
+// recording costs about what it does in a latency_histogram.
+class atomic_latency_histogram
+{
+public:
+    // only ever called by the one recording thread
+    void record(const uint64_t value_)
+    {
+        bump(_counts[latency_histogram::bucket_index(value_)]);
+        _sum.store(_sum.load(std::memory_order_relaxed) + value_, std::memory_order_relaxed);
+        if (value_ > _max.load(std::memory_order_relaxed))
+            _max.store(value_, std::memory_order_relaxed);
+    }
+
+    // may be a few records behind. The count is the buckets' sum, so it
+    // always agrees with them; sum and max may be off by the records in flight
+    latency_histogram snapshot() const
+    {
+        latency_histogram histogram {};
+        for (size_t i = 0; i < _counts.size(); ++i)
+        {
+            histogram._counts[i] = _counts[i].load(std::memory_order_relaxed);
+            histogram._total_count += histogram._counts[i];
+        }
+        histogram._sum         = _sum.load(std::memory_order_relaxed);
+        histogram._max         = _max.load(std::memory_order_relaxed);
+        return histogram;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter_)
+    {
+        counter_.store(counter_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, latency_histogram::BUCKETS> _counts {};
+    std::atomic<uint64_t> _sum {};
+    std::atomic<uint64_t> _max {};
+};
+
+} // namespace gby
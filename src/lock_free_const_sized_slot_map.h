@@ -1,6 +1,12 @@
 
 #pragma once
 
+#include "utils.h"
+#include "backoff.h"
+#include "slot_map_stats.h"
+#include "slot_map_probes.h"
+#include "slot_map_result.h"
+
 #include <utility>
 #include <vector>
 #include <deque>
@@ -10,6 +16,9 @@
 #include <stdexcept>
 #include <tuple>
 #include <limits>
+#include <optional>
+#include <functional>
+#include <type_traits>
 
 
 namespace gby
@@ -53,57 +62,79 @@ public:
             , _conservative_size {}
             , _size {}
     {
-        _next_available_slot_index.store(0); // first element of slot container
-         
-        for (key_index_type slot_idx {}; slot_idx < _slots.size(); ++slot_idx)
-        {
-            _slots[slot_idx] = std::make_pair(slot_idx+1, key_generation_type{});
-        }
-        
-        _sentinel_last_slot_index.store(_slots.size()-1);
+        // slot 0 starts out as the sentinel of the (empty) free list, every
+        // other slot is fresh - handed out by _fresh_slot_index when first used
+        _next_available_slot_index.store({0, 0});
+        _sentinel_last_slot_index.store(0);
     }
 
     constexpr key_type insert(const T& value)   { return this->emplace(value);            }
     constexpr key_type insert(T&& value)        { return this->emplace(std::move(value)); }
 
+    // blocks until an erase frees up a slot instead of throwing when the map is full
+    constexpr key_type insert_wait(const T& value)   { return *this->emplaceUntil(std::nullopt, value);            }
+    constexpr key_type insert_wait(T&& value)        { return *this->emplaceUntil(std::nullopt, std::move(value)); }
+
+    // same as insert_wait, but gives up (returning an empty optional) once timeout_ has passed
+    template<class Rep, class Period>
+    constexpr std::optional<key_type> try_insert_for(const T& value, const std::chrono::duration<Rep, Period>& timeout_)
+    {
+        return this->emplaceUntil(std::chrono::steady_clock::now() + timeout_, value);
+    }
+
+    template<class Rep, class Period>
+    constexpr std::optional<key_type> try_insert_for(T&& value, const std::chrono::duration<Rep, Period>& timeout_)
+    {
+        return this->emplaceUntil(std::chrono::steady_clock::now() + timeout_, std::move(value));
+    }
+
     template<class ... Args> 
     constexpr key_type emplace(Args&& ... args) 
     {
-        /*
-        if slots or values array is full, return error/exception/etc
+        if (auto key = try_emplace(std::forward<Args>(args)...))
+            return *key;
 
-        increment values size atomically
-        emplace element into value spot
-        insert into slots array the new value slot
-            - CAS on next_available_slot_index, whether it has changed, and if not switch it with the next in line.
-            - edit new slot object
-            - increment slots size
-        */
-        slot_index_type cur_slot_idx {};
-        do 
-        {
-            cur_slot_idx = _next_available_slot_index.load(std::memory_order_acquire);
+        throw_or_abort<std::length_error>("Slot Map is at max capacity.");
+    }
 
-            if (cur_slot_idx == _sentinel_last_slot_index.load(std::memory_order_acquire))
-                throw std::length_error("Slot Map is at max capacity.");
-        }
-        while (!_next_available_slot_index.compare_exchange_strong(cur_slot_idx, get_index<slot_type>(_slots[cur_slot_idx]))); 
+    // returns an empty optional if the map is full, in which case args are left untouched
+    template<class ... Args> 
+    constexpr std::optional<key_type> try_emplace(Args&& ... args) 
+    {
+        return tryEmplaceImpl(unbounded_attempts, std::forward<Args>(args)...);
+    }
 
-        slot_index_type cur_value_idx {};
-        do 
-        {
-            cur_value_idx = _conservative_size.load(std::memory_order_acquire);
-        }
-        while (!_size.compare_exchange_strong(cur_value_idx, cur_value_idx+1));
-        
-        _data[cur_value_idx] = std::forward<Args...>(args...);
-        slot_type& cur_slot = _slots[cur_slot_idx]; 
-        set_index(cur_slot, cur_value_idx);
-        _reverse_array[cur_value_idx] = cur_slot_idx;
+    // same as try_emplace, but also gives up once max_attempts_ attempts at
+    // claiming a slot lost to other inserters, instead of retrying until one
+    // wins - or once max_attempts_ attempts at claiming the element's place
+    // found the inserter or drain ahead of it still publishing its element.
+    constexpr std::optional<key_type> try_insert(const T& value, const size_t max_attempts_ = default_try_attempts)
+    {
+        return tryEmplaceImpl(max_attempts_, value);
+    }
 
-        _conservative_size.store(cur_value_idx+1, std::memory_order_release);
+    constexpr std::optional<key_type> try_insert(T&& value, const size_t max_attempts_ = default_try_attempts)
+    {
+        return tryEmplaceImpl(max_attempts_, std::move(value));
+    }
 
-        return {cur_slot_idx, get_generation(cur_slot).load(std::memory_order_relaxed)};       
+    // try_insert that reports a failure as slot_map_errc::full, and never throws
+    constexpr slot_map_result<key_type> insert_nothrow(const T& value, const size_t max_attempts_ = default_try_attempts)
+            noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        if (auto key = tryEmplaceImpl(max_attempts_, value); likely(key.has_value()))
+            return *key;
+        else
+            return slot_map_errc::full;
+    }
+
+    constexpr slot_map_result<key_type> insert_nothrow(T&& value, const size_t max_attempts_ = default_try_attempts)
+            noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        if (auto key = tryEmplaceImpl(max_attempts_, std::move(value)); likely(key.has_value()))
+            return *key;
+        else
+            return slot_map_errc::full;
     }
 
     // this is non blocking. if another thread is currently iterating,
@@ -112,6 +143,7 @@ public:
     {
         if (addToEraseQueue(key))
         {
+        _stats.drain_attempted();
         std::unique_lock ul (_iterationLock, std::try_to_lock);
         if (ul.owns_lock())
             drainEraseQueue();
@@ -121,9 +153,11 @@ public:
     template<bool Block>
     constexpr void flushEraseQueue()
     {
+        _stats.drain_attempted();
         if constexpr(Block) 
         {
-            std::unique_lock ul (_iterationLock);
+            std::unique_lock ul (_iterationLock, std::defer_lock);
+            _stats.lock(ul);
             assert(ul.owns_lock());
             drainEraseQueue();
         }
@@ -139,8 +173,10 @@ public:
     template <class P>
     constexpr void iterate_map(P pred) 
     {
-        std::unique_lock ul (_iterationLock);
+        std::unique_lock ul (_iterationLock, std::defer_lock);
+        _stats.lock(ul);
         assert(ul.owns_lock());
+        GBY_SLOT_MAP_PROBE(iterate_begin, this);
 
         size_t i {};
         size_t size {};
@@ -151,7 +187,9 @@ public:
                 pred(_data[i]);
         } 
         while (size != _conservative_size.load(std::memory_order_relaxed));
+        GBY_SLOT_MAP_PROBE(iterate_end, this);
 
+        _stats.drain_attempted();
         drainEraseQueue();
     }
 
@@ -159,6 +197,18 @@ public:
     constexpr size_t capacity() const { return _data.capacity(); }
     constexpr bool   empty()    const { return size() == 0; }
 
+    memory_usage_breakdown memory_usage() const
+    {
+        return {_slots.capacity()         * sizeof(slot_type),
+                _data.capacity()          * sizeof(value_type),
+                _reverse_array.capacity() * sizeof(typename decltype(_reverse_array)::value_type),
+                _erase_array.capacity()   * sizeof(typename decltype(_erase_array)::value_type),
+                0};
+    }
+
+    // all zeros unless built with GBY_SLOT_MAP_STATS, see slot_map_stats.h
+    slot_map_stats stats() const { return _stats.snapshot(); }
+
     constexpr reference operator[](const key_type& key)              
     { 
         return find_unchecked(key);
@@ -171,18 +221,16 @@ public:
 
     constexpr std::optional<std::reference_wrapper<value_type>> at(const key_type& key)
     {
-        if (const auto&[idx,gen] = key; idx >=Size)
-            throw std::out_of_range("Index " + std::to_string(idx) + 
-                    " is larger than Slot Map size of " + std::to_string(Size));
+        if (const auto&[idx,gen] = key; unlikely(static_cast<size_t>(idx) > Size))
+            throw_or_abort<std::out_of_range>("Slot Map key index is out of range.");
         
         return find(key);
     }
 
     constexpr std::optional<std::reference_wrapper<const value_type>> at(const key_type& key) const
     {
-        if (const auto&[idx, gen] = key; idx >= Size)
-            throw std::out_of_range("Index " + std::to_string(idx) + 
-                    " is larger than Slot Map size of " + std::to_string(Size));
+        if (const auto&[idx, gen] = key; unlikely(static_cast<size_t>(idx) > Size))
+            throw_or_abort<std::out_of_range>("Slot Map key index is out of range.");
         
         return find(key);
     }
@@ -203,6 +251,24 @@ public:
             return {};
     }
 
+    // find() that tells why it found nothing: slot_map_errc::out_of_range if the
+    // key's index is past the slots, slot_map_errc::stale_key if its element is gone
+    constexpr slot_map_result<std::reference_wrapper<value_type>> lookup(const key_type& key) noexcept
+    {
+        if (auto slot = get_slot(key); likely(slot.has_value()))
+            return std::ref(_data[get_index<slot_type>(*slot)]);
+        else
+            return slot.error();
+    }
+
+    constexpr slot_map_result<std::reference_wrapper<const value_type>> lookup(const key_type& key) const noexcept
+    {
+        if (auto slot = get_slot(key); likely(slot.has_value()))
+            return std::cref(_data[get_index<slot_type>(*slot)]);
+        else
+            return slot.error();
+    }
+
     constexpr reference find_unchecked(const key_type& key) 
     {
         const auto& slot {_slots[get_index<key_type>(key)]};
@@ -218,53 +284,44 @@ public:
 private:
     constexpr std::optional<std::reference_wrapper<slot_type>> get_and_increment_slot(const key_type &key) noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > Size))
+            return {};
 
-            auto &slot = _slots[idx];
+        auto &slot = _slots[idx];
+
+        key_generation_type genCpy = gen;
+        auto& slotGen = const_cast<slot_generation_type&>(get_generation(slot));
+        if (slotGen.compare_exchange_strong(genCpy, genCpy+1))
+            return slot;
 
-            key_generation_type genCpy = gen;
-            auto& slotGen = const_cast<slot_generation_type&>(get_generation(slot));
-            if (slotGen.compare_exchange_strong(genCpy, genCpy+1))
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
-        
         return {};
     }
 
-    constexpr std::optional<std::reference_wrapper<const slot_type>> get_slot(const key_type &key) const noexcept
+    constexpr slot_map_result<std::reference_wrapper<const slot_type>> get_slot(const key_type &key) const noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > Size))
+            return slot_map_errc::out_of_range;
 
-            auto &slot = _slots[idx];
-            if (get_generation(slot).load(std::memory_order_relaxed) == gen)
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
-        
-        return {};
+        auto &slot = _slots[idx];
+        if (get_generation(slot).load(std::memory_order_relaxed) == gen)
+            return std::ref(slot);
+
+        return slot_map_errc::stale_key;
     }
 
-    constexpr std::optional<std::reference_wrapper<slot_type>> get_slot(const key_type &key) noexcept
+    constexpr slot_map_result<std::reference_wrapper<slot_type>> get_slot(const key_type &key) noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > Size))
+            return slot_map_errc::out_of_range;
 
-            auto &slot = _slots[idx];
-            if (get_generation(slot).load(std::memory_order_relaxed) == gen)
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
+        auto &slot = _slots[idx];
+        if (get_generation(slot).load(std::memory_order_relaxed) == gen)
+            return std::ref(slot);
 
-        return {};
+        return slot_map_errc::stale_key;
     }
 
     bool addToEraseQueue(const key_type &key)
@@ -273,7 +330,12 @@ private:
         if (slot)
         {
             size_t index = _erase_array_length.fetch_add(1);
-            _erase_array[index] = key;
+            publish_erase_entry(_erase_array[index], get_index(key));
+            _stats.erase_queued(index+1);
+            GBY_SLOT_MAP_PROBE(erase_enqueue, this, get_index(key), index+1);
+
+            // a waiting inserter can drain the queue itself
+            wakeWaitingInserters();
             return true;
         }
         return false;
@@ -291,26 +353,34 @@ private:
                 - switch end-of-values slot to this index & decrement values size
                 - add current slot to free slots list
         */
+        GBY_SLOT_MAP_PROBE(drain_begin, this);
+        trace_span span {"drain", "elements"};
+
         size_t cur_erase_array_length {};
         size_t erase_idx {};
-        do 
+        while (true)
         {
             cur_erase_array_length = _erase_array_length.load(std::memory_order_acquire);
 
             for ( ; erase_idx < cur_erase_array_length; ++erase_idx) 
             {
-                const size_t slot_to_erase_idx = get_index(_erase_array[erase_idx]);
+                const size_t slot_to_erase_idx = take_erase_entry(_erase_array[erase_idx]);
                 slot_type &slot_to_erase = _slots[slot_to_erase_idx];
                 size_t data_idx_to_free = get_index(slot_to_erase);
 
                 // replace object with the current last object in data array
                 slot_index_type data_arr_len {};
-                do 
+                backoff bo;
+                while (true)
                 {
                     data_arr_len = _conservative_size.load(std::memory_order_acquire);
                     _data[data_idx_to_free] = _data[data_arr_len-1];
+                    if (_size.compare_exchange_strong(data_arr_len, data_arr_len-1))
+                        break;
+
+                    _stats.cas_failure(cas_site::size);
+                    bo.pause();
                 }
-                while (!_size.compare_exchange_strong(data_arr_len, data_arr_len-1));
 
                 size_t slot_to_update_idx = _reverse_array[data_arr_len-1];
                 slot_type &slot_to_update = _slots[slot_to_update_idx];
@@ -326,24 +396,191 @@ private:
                 set_index(_slots[previous_sentinel], slot_to_erase_idx);
                 _sentinel_last_slot_index.store(slot_to_erase_idx, std::memory_order_release);
             }
+
+            if (_erase_array_length.compare_exchange_strong(cur_erase_array_length, 0))
+                break;
+            _stats.cas_failure(cas_site::drain);
         }
-        while (!_erase_array_length.compare_exchange_strong(cur_erase_array_length, 0));
     
         assert(cur_erase_array_length == erase_idx);
+        _stats.drained(erase_idx);
+        span.set_arg(erase_idx);
+        GBY_SLOT_MAP_PROBE(drain_end, this, erase_idx);
+
+        wakeWaitingInserters();
     }
 
+    template<class ... Args>
+    std::optional<key_type> tryEmplaceImpl(const size_t max_attempts_, Args&& ... args)
+    {
+        /*
+        if slots or values array is full, return error/exception/etc
 
-    std::vector<slot_type> _slots = std::vector<slot_type>(Size+1); // +1 for sentinel
-    container_type         _data = container_type(Size);
-    std::vector<size_t>    _reverse_array = std::vector<size_t>(Size);
+        increment values size atomically
+        emplace element into value spot
+        insert into slots array the new value slot
+            - CAS on next_available_slot_index, whether it has changed, and if not switch it with the next in line.
+            - edit new slot object
+            - increment slots size
+        */
+        GBY_SLOT_MAP_PROBE(insert_start, this);
+
+        const auto acquired_slot_idx = acquireSlot(max_attempts_);
+        if (unlikely(!acquired_slot_idx))
+        {
+            GBY_SLOT_MAP_PROBE(insert_end, this, -1);
+            return {};
+        }
+        const slot_index_type cur_slot_idx = *acquired_slot_idx;
+
+        // wait for the previous insertion/deletion to publish its element. A
+        // preempted one can hold this up for a while, so after max_attempts_
+        // the slot goes back and the insert gives up.
+        slot_index_type cur_value_idx {};
+        backoff bo;
+        for (size_t attempt = 1; ; ++attempt)
+        {
+            cur_value_idx = _conservative_size.load(std::memory_order_acquire);
+            if (_size.compare_exchange_strong(cur_value_idx, cur_value_idx+1))
+                break;
+
+            _stats.cas_failure(cas_site::size);
+            if (attempt == max_attempts_)
+            {
+                releaseSlot(cur_slot_idx);
+                GBY_SLOT_MAP_PROBE(insert_end, this, -1);
+                return {};
+            }
+            bo.pause();
+        }
+        
+        _data[cur_value_idx] = std::forward<Args...>(args...);
+        slot_type& cur_slot = _slots[cur_slot_idx]; 
+        set_index(cur_slot, cur_value_idx);
+        _reverse_array[cur_value_idx] = cur_slot_idx;
+
+        _conservative_size.store(cur_value_idx+1, std::memory_order_release);
+
+        GBY_SLOT_MAP_PROBE(insert_end, this, cur_slot_idx);
+        return key_type{cur_slot_idx, get_generation(cur_slot).load(std::memory_order_relaxed)};       
+    }
 
-    // free list used to keep track of the available slots in the slot array
-    std::atomic<key_index_type> _next_available_slot_index;
+    // a recycled slot off the free list if there is one (it's still warm in
+    // cache), otherwise the next fresh one. Empty if the map is full, or once
+    // max_attempts_ compare-exchanges in a row lost to other inserters.
+    std::optional<slot_index_type> acquireSlot(const size_t max_attempts_ = unbounded_attempts)
+    {
+        backoff bo;
+        for (size_t attempt = 1; ; ++attempt)
+        {
+            tagged_slot_index head = _next_available_slot_index.load(std::memory_order_acquire);
+            if (head.idx != _sentinel_last_slot_index.load(std::memory_order_acquire))
+            {
+                const tagged_slot_index next {get_index<slot_type>(_slots[head.idx]), static_cast<slot_tag_type>(head.tag+1)};
+                if (_next_available_slot_index.compare_exchange_strong(head, next))
+                    return head.idx;
+                _stats.cas_failure(cas_site::free_list);
+                GBY_SLOT_MAP_PROBE(free_list_cas_retry, this);
+            }
+            else
+            {
+                // fresh slots are zeroed and never linked, so claiming one is all it takes
+                slot_index_type fresh_slot_idx = _fresh_slot_index.load(std::memory_order_relaxed);
+                if (unlikely(static_cast<size_t>(fresh_slot_idx) > Size))
+                    return {};
+
+                if (_fresh_slot_index.compare_exchange_strong(fresh_slot_idx, fresh_slot_idx+1, std::memory_order_relaxed))
+                    return fresh_slot_idx;
+                _stats.cas_failure(cas_site::fresh_slot);
+            }
+
+            if (attempt == max_attempts_)
+                return {};
+            bo.pause();
+        }
+    }
+
+    // puts a slot acquireSlot handed out, but that was never used, back at the
+    // front of the free list
+    void releaseSlot(const slot_index_type slot_idx_)
+    {
+        tagged_slot_index head = _next_available_slot_index.load(std::memory_order_acquire);
+        tagged_slot_index released {};
+        do
+        {
+            set_index(_slots[slot_idx_], head.idx);
+            released = {slot_idx_, static_cast<slot_tag_type>(head.tag+1)};
+        }
+        while (!_next_available_slot_index.compare_exchange_weak(head, released, std::memory_order_release, std::memory_order_acquire));
+
+        wakeWaitingInserters();
+    }
+
+    // deadline_ of std::nullopt waits indefinitely. Must not be called from within iterate_map.
+    template<class ... Args>
+    std::optional<key_type> emplaceUntil(const std::optional<std::chrono::steady_clock::time_point> deadline_, Args&& ... args)
+    {
+        std::optional<key_type> key {};
+        _waiting_inserters.fetch_add(1, std::memory_order_seq_cst);
+        while (true)
+        {
+            const auto free_epoch = _free_epoch.load(std::memory_order_acquire);
+            if ((key = try_emplace(std::forward<Args>(args)...)))
+                break;
+
+            // erased slots are only freed once drained, so don't wait on a drain that might not come
+            if (_erase_array_length.load(std::memory_order_seq_cst) > 0)
+            {
+                flushEraseQueue<true>();
+                continue;
+            }
+
+            if (!deadline_)
+                spin_then_park(_free_epoch, free_epoch);
+            else if (!spin_then_wait_until(_free_epoch, free_epoch, *deadline_))
+                break;
+        }
+        _waiting_inserters.fetch_sub(1, std::memory_order_relaxed);
+
+        return key;
+    }
+
+    void wakeWaitingInserters()
+    {
+        // pairs with the seq_cst increment of _waiting_inserters, so that either we
+        // see the waiter or the waiter sees the erased element/freed slot.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_waiting_inserters.load(std::memory_order_relaxed) > 0)
+        {
+            _free_epoch.fetch_add(1, std::memory_order_acq_rel);
+            _free_epoch.notify_all();
+        }
+    }
+
+
+    std::vector<slot_type, zeroed_allocator<slot_type>> _slots = decltype(_slots)(Size+1); // +1 for sentinel
+    container_type         _data = container_type(Size);
+    std::vector<size_t, zeroed_allocator<size_t>> _reverse_array = decltype(_reverse_array)(Size);
+
+    // free list of the recycled slots in the slot array. Inserters pop it
+    // without a lock, so its head is tagged with a count of its changes: a
+    // head that was popped and came back around while another inserter read
+    // its link then fails that inserter's compare-exchange (ABA).
+    using slot_tag_type = std::make_unsigned_t<slot_index_type>;
+    struct tagged_slot_index
+    {
+        slot_index_type idx;
+        slot_tag_type   tag;
+    };
+    std::atomic<tagged_slot_index> _next_available_slot_index;
     std::atomic<key_index_type> _sentinel_last_slot_index;
+
+    // high-water mark of the slots ever used: the slots from here to Size are fresh
+    std::atomic<key_index_type> _fresh_slot_index {1};
     
     // stack used to store elements to be deleted. This is only used if trying
     // to delete while iterating- otherwise the elemnt gets deleted on the spot
-    std::vector<key_type> _erase_array = std::vector<key_type>(Size);
+    std::vector<slot_index_type, zeroed_allocator<slot_index_type>> _erase_array = decltype(_erase_array)(Size);
     std::atomic<size_t>  _erase_array_length;
 
     // number of elements in the values container. Unless caught in the middle 
@@ -354,6 +591,14 @@ private:
 
     // enforces that we can't iterate & delete at the same time
     std::mutex _iterationLock;
+
+    // used by insert_wait/try_insert_for to wait on a full map. _free_epoch is
+    // bumped (only if someone is waiting) whenever an erase is queued or drained.
+    std::atomic<size_t>   _waiting_inserters {};
+    std::atomic<uint32_t> _free_epoch {};
+
+    using cas_site = slot_map_counters::cas_site;
+    [[no_unique_address]] slot_map_counters _stats;
 };
 
 } // namespace gby
@@ -15,6 +15,10 @@
 #include <math.h>
 #include <concepts>
 #include <atomic>
+#include <array>
+#include <assert.h>
+#include <memory>
+#include <stdexcept>
 
 #include "utils.h"
 
@@ -196,10 +200,14 @@ private:
 
     constexpr value_type& at(const size_type i_)
     {
-        if (i_ >= size())
-        {
-            throw std::out_of_range("index " + std::to_string(i_) + " outside of size " + std::to_string(size()) + ".");
-        }
+        if (unlikely(i_ >= size()))
+            throw_or_abort<std::out_of_range>("lock_free_vector index out of range.");
+        return element(i_);
+    }
+
+    // no bounds check - the pending write's position isn't counted in size() yet
+    constexpr value_type& element(const size_type i_)
+    {
         auto [bucket, idx] = getLocation(i_); 
         T* arr = _bucketArr[bucket].second.load(); 
         return arr[idx];
@@ -212,7 +220,7 @@ private:
 
         if (writeDesc && !writeDesc->_completed)
         {
-            value_type& ele = at(writeDesc->_position); 
+            value_type& ele = element(writeDesc->_position); 
             ele = writeDesc->_val;
             writeDesc->_completed = true;
         }
@@ -229,7 +237,7 @@ private:
         value_type* L_VALUE_NULLPTR = nullptr;
 
         if (bucket_ >= BUCKET_COUNT)
-            throw std::length_error("Lock-free array reached max bucket size."); 
+            throw_or_abort<std::length_error>("Lock-free array reached max bucket size.");
         
         const size_t bucketSize = pow(FIRST_BUCKET_SIZE, bucket_+1);
         T* newMemBlock = new T[bucketSize]();
@@ -7,10 +7,15 @@
 
 
 #include "slot_map.h"
+#include "utils.h"
+#include "slot_map_result.h"
 
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <mutex>
 #include <shared_mutex>
+#include <type_traits>
 
 namespace gby
 {
@@ -98,6 +103,27 @@ public:
         return slot_map.find(key);
     }
 
+    // lookup() methods - find() that tells why it found nothing
+    constexpr slot_map_result<std::reference_wrapper<mapped_type>> lookup(const key_type& key) noexcept
+    {
+        std::shared_lock sl{m};
+        if (unlikely(static_cast<size_t>(get_index(key)) >= slot_map.slot_count()))
+            return slot_map_errc::out_of_range;
+        if (auto it = slot_map.find(key); likely(it != slot_map.end()))
+            return std::ref(*it);
+        return slot_map_errc::stale_key;
+    }
+
+    constexpr slot_map_result<std::reference_wrapper<const mapped_type>> lookup(const key_type& key) const noexcept
+    {
+        std::shared_lock sl{m};
+        if (unlikely(static_cast<size_t>(get_index(key)) >= slot_map.slot_count()))
+            return slot_map_errc::out_of_range;
+        if (auto it = slot_map.find(key); likely(it != slot_map.end()))
+            return std::cref(*it);
+        return slot_map_errc::stale_key;
+    }
+
     // find_unchecked() methods
     constexpr iterator find_unchecked(const key_type& key) 
     {
@@ -143,6 +169,22 @@ public:
         return slot_map.capacity();
     }
     
+    // estimated through slot_map's interface: its reverse map grows along
+    // with the values, and spare slot capacity isn't visible
+    memory_usage_breakdown memory_usage() const
+    {
+        std::shared_lock sl{m};
+        size_type values = slot_map.size();
+        if constexpr (requires { slot_map.capacity(); })
+            values = slot_map.capacity();
+
+        memory_usage_breakdown usage {};
+        usage.slots         = slot_map.slot_count() * sizeof(key_type);
+        usage.data          = values * sizeof(mapped_type);
+        usage.reverse_array = values * sizeof(key_index_type);
+        return usage;
+    }
+
     constexpr void reserve_slots(size_type n) 
     {
         std::lock_guard lg{m};
@@ -174,6 +216,25 @@ public:
         return slot_map.emplace(std::forward<Args>(args)...); 
     }
 
+    // insert that reports running out of key indices as slot_map_errc::full
+    // instead of throwing. The wrapped map grows its vectors as it needs to,
+    // so a failed allocation terminates.
+    constexpr slot_map_result<key_type> insert_nothrow(const mapped_type& value) noexcept
+    {
+        std::lock_guard lg{m};
+        if (unlikely(slot_map.size() >= max_key_indices))
+            return slot_map_errc::full;
+        return slot_map.insert(value);
+    }
+
+    constexpr slot_map_result<key_type> insert_nothrow(mapped_type&& value) noexcept
+    {
+        std::lock_guard lg{m};
+        if (unlikely(slot_map.size() >= max_key_indices))
+            return slot_map_errc::full;
+        return slot_map.insert(std::move(value));
+    }
+
 
     constexpr iterator erase(iterator pos) 
     { 
@@ -228,6 +289,8 @@ public:
     constexpr const_reverse_iterator crbegin() const   { return slot_map.rbegin(); }
     constexpr const_reverse_iterator crend() const     { return slot_map.rend(); }
 private:
+    static constexpr size_t max_key_indices = std::numeric_limits<key_index_type>::max();
+
     mutable std::shared_mutex m;
     stdext::slot_map<T, Key, Container> slot_map;
 };
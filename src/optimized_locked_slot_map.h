@@ -11,6 +11,10 @@
 #pragma once
 
 #include "utils.h"
+#include "backoff.h"
+#include "slot_map_stats.h"
+#include "slot_map_probes.h"
+#include "slot_map_result.h"
 
 #include <utility>
 #include <vector>
@@ -20,6 +24,8 @@
 #include <atomic>
 #include <mutex>
 #include <optional>
+#include <functional>
+#include <type_traits>
 #include <shared_mutex>
 #include <stdexcept>
 #include <tuple>
@@ -67,56 +73,77 @@ public:
             , _conservative_size {0}
             , _size {0}
     {
-        _next_available_slot_index.store(0); // first element of slot container
-         
-        for (slot_index_type slot_idx {}; slot_idx < Size; ++slot_idx)
-        {
-            _slots[slot_idx] = std::make_pair(slot_idx+1, key_generation_type{});
-        }
-        
-        _slots[Size] = std::make_pair(Size, key_generation_type{});
-        _sentinel_last_slot_index.store(Size);
+        // slot 0 starts out as the sentinel of the (empty) free list, every
+        // other slot is fresh - handed out by _fresh_slot_index when first used
+        _next_available_slot_index.store(0);
+        _sentinel_last_slot_index.store(0);
     }
 
     constexpr key_type insert(const T& value)   { return this->emplace(value);            }
     constexpr key_type insert(T&& value)        { return this->emplace(std::move(value)); }
 
+    // blocks until an erase frees up a slot instead of throwing when the map is full
+    constexpr key_type insert_wait(const T& value)   { return *this->emplaceUntil(std::nullopt, value);            }
+    constexpr key_type insert_wait(T&& value)        { return *this->emplaceUntil(std::nullopt, std::move(value)); }
+
+    // same as insert_wait, but gives up (returning an empty optional) once timeout_ has passed
+    template<class Rep, class Period>
+    constexpr std::optional<key_type> try_insert_for(const T& value, const std::chrono::duration<Rep, Period>& timeout_)
+    {
+        return this->emplaceUntil(std::chrono::steady_clock::now() + timeout_, value);
+    }
+
+    template<class Rep, class Period>
+    constexpr std::optional<key_type> try_insert_for(T&& value, const std::chrono::duration<Rep, Period>& timeout_)
+    {
+        return this->emplaceUntil(std::chrono::steady_clock::now() + timeout_, std::move(value));
+    }
+
     template<class ... Args> 
     constexpr key_type emplace(Args&& ... args) 
     {
-        slot_index_type cur_slot_idx {};
-        do 
-        {
-            cur_slot_idx = _next_available_slot_index.load(std::memory_order_acquire);
+        if (auto key = try_emplace(std::forward<Args>(args)...))
+            return *key;
 
-            if (unlikely(cur_slot_idx == _sentinel_last_slot_index.load(std::memory_order_acquire)))
-                throw std::length_error("Slot Map is at max capacity.");
-        }
-        while (!_next_available_slot_index.compare_exchange_strong(cur_slot_idx, get_index<slot_type>(_slots[cur_slot_idx]))); 
+        throw_or_abort<std::length_error>("Slot Map is at max capacity.");
+    }
 
-        slot_type* cur_slot {};
-        {
-            std::shared_lock lg {_eraseMut};
+    // returns an empty optional if the map is full, in which case args are left untouched
+    template<class ... Args> 
+    constexpr std::optional<key_type> try_emplace(Args&& ... args) 
+    {
+        return tryEmplaceImpl(unbounded_attempts, std::forward<Args>(args)...);
+    }
 
-            slot_index_type cur_value_idx = _size.fetch_add(1, std::memory_order_acq_rel);
+    // same as try_emplace, but also gives up once max_attempts_ attempts at
+    // claiming a slot lost to other inserters, instead of retrying until one wins
+    constexpr std::optional<key_type> try_insert(const T& value, const size_t max_attempts_ = default_try_attempts)
+    {
+        return tryEmplaceImpl(max_attempts_, value);
+    }
 
-            _data[cur_value_idx] = std::forward<Args...>(args...);
+    constexpr std::optional<key_type> try_insert(T&& value, const size_t max_attempts_ = default_try_attempts)
+    {
+        return tryEmplaceImpl(max_attempts_, std::move(value));
+    }
 
-            cur_slot = &_slots[cur_slot_idx]; 
-            set_index(*cur_slot, cur_value_idx);
-            _reverse_array[cur_value_idx] = cur_slot_idx;            
+    // try_insert that reports a failure as slot_map_errc::full, and never throws
+    constexpr slot_map_result<key_type> insert_nothrow(const T& value, const size_t max_attempts_ = default_try_attempts)
+            noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        if (auto key = tryEmplaceImpl(max_attempts_, value); likely(key.has_value()))
+            return *key;
+        else
+            return slot_map_errc::full;
+    }
 
-            slot_index_type conservSize{};
-            do 
-            {
-                conservSize = _conservative_size.load(std::memory_order_acquire);
-                if (get_index(_slots[_reverse_array[conservSize]]) != conservSize)
-                    break;
-            }
-            while (conservSize < _size.load(std::memory_order_acquire) && _conservative_size.compare_exchange_strong(conservSize, conservSize+1));
-        }        
-        
-        return {cur_slot_idx, get_generation(*cur_slot).load(std::memory_order_acquire)};       
+    constexpr slot_map_result<key_type> insert_nothrow(T&& value, const size_t max_attempts_ = default_try_attempts)
+            noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        if (auto key = tryEmplaceImpl(max_attempts_, std::move(value)); likely(key.has_value()))
+            return *key;
+        else
+            return slot_map_errc::full;
     }
 
     // this is non blocking. if another thread is currently iterating,
@@ -137,7 +164,9 @@ public:
     constexpr void iterate_map(P pred) 
     {
         {
-            std::shared_lock sl {_eraseMut};
+            std::shared_lock sl {_eraseMut, std::defer_lock};
+            _stats.lock(sl);
+            GBY_SLOT_MAP_PROBE(iterate_begin, this);
 
             size_t i {};
             size_t size {};
@@ -148,6 +177,8 @@ public:
                     pred(_data[i]);
             } 
             while (size != _conservative_size.load(std::memory_order_acquire));
+
+            GBY_SLOT_MAP_PROBE(iterate_end, this);
         }
 
         drainEraseQueue();
@@ -157,6 +188,18 @@ public:
     constexpr size_t capacity() const { return _data.capacity(); }
     constexpr bool   empty()    const { return size() == 0; }
 
+    memory_usage_breakdown memory_usage() const
+    {
+        return {_slots.capacity()         * sizeof(slot_type),
+                _data.capacity()          * sizeof(value_type),
+                _reverse_array.capacity() * sizeof(typename decltype(_reverse_array)::value_type),
+                _erase_array.capacity()   * sizeof(typename decltype(_erase_array)::value_type),
+                0};
+    }
+
+    // all zeros unless built with GBY_SLOT_MAP_STATS, see slot_map_stats.h
+    slot_map_stats stats() const { return _stats.snapshot(); }
+
     constexpr reference operator[](const key_type& key)              
     { 
         return find_unchecked(key);
@@ -169,18 +212,16 @@ public:
 
     constexpr std::optional<std::reference_wrapper<value_type>> at(const key_type& key)
     {
-        if (const auto&[idx,gen] = key; idx >=Size)
-            throw std::out_of_range("Index " + std::to_string(idx) + 
-                    " is larger than Slot Map size of " + std::to_string(Size));
+        if (const auto&[idx,gen] = key; unlikely(static_cast<size_t>(idx) > Size))
+            throw_or_abort<std::out_of_range>("Slot Map key index is out of range.");
         
         return find(key);
     }
 
     constexpr std::optional<std::reference_wrapper<const value_type>> at(const key_type& key) const
     {
-        if (const auto&[idx, gen] = key; idx >= Size)
-            throw std::out_of_range("Index " + std::to_string(idx) + 
-                    " is larger than Slot Map size of " + std::to_string(Size));
+        if (const auto&[idx, gen] = key; unlikely(static_cast<size_t>(idx) > Size))
+            throw_or_abort<std::out_of_range>("Slot Map key index is out of range.");
         
         return find(key);
     }
@@ -201,6 +242,24 @@ public:
             return {};
     }
 
+    // find() that tells why it found nothing: slot_map_errc::out_of_range if the
+    // key's index is past the slots, slot_map_errc::stale_key if its element is gone
+    constexpr slot_map_result<std::reference_wrapper<value_type>> lookup(const key_type& key) noexcept
+    {
+        if (auto slot = get_slot(key); likely(slot.has_value()))
+            return std::ref(_data[get_index<slot_type>(*slot)]);
+        else
+            return slot.error();
+    }
+
+    constexpr slot_map_result<std::reference_wrapper<const value_type>> lookup(const key_type& key) const noexcept
+    {
+        if (auto slot = get_slot(key); likely(slot.has_value()))
+            return std::cref(_data[get_index<slot_type>(*slot)]);
+        else
+            return slot.error();
+    }
+
     constexpr reference find_unchecked(const key_type& key) 
     {
         const auto& slot {_slots[get_index<key_type>(key)]};
@@ -216,9 +275,11 @@ public:
     template<bool Block=false>
     void drainEraseQueue()
     {
+        _stats.drain_attempted();
         if constexpr (Block)
         {
-            std::unique_lock ul {_eraseMut};
+            std::unique_lock ul {_eraseMut, std::defer_lock};
+            _stats.lock(ul);
             drainEraseQueueImpl();
         }
         else
@@ -234,68 +295,57 @@ public:
 public:
     constexpr bool validate_and_increment_slot(const key_type &key) noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > Size))
+            return false;
 
-            auto &slot = _slots[idx];
+        auto &slot = _slots[idx];
+
+        key_generation_type genCpy = gen;
+        auto& slotGen = const_cast<slot_generation_type&>(get_generation(slot));
+        if (slotGen.compare_exchange_strong(genCpy, genCpy+1))
+            return true;
 
-            key_generation_type genCpy = gen;
-            auto& slotGen = const_cast<slot_generation_type&>(get_generation(slot));
-            if (slotGen.compare_exchange_strong(genCpy, genCpy+1))
-                return true;
-        }
-        catch(const std::out_of_range &e) 
-        {}
-        
         return false;
     }
 
-    constexpr std::optional<std::reference_wrapper<const slot_type>> get_slot(const key_type &key) const noexcept
+    constexpr slot_map_result<std::reference_wrapper<const slot_type>> get_slot(const key_type &key) const noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > Size))
+            return slot_map_errc::out_of_range;
 
-            auto &slot = _slots[idx];
-            if (get_generation(slot).load(std::memory_order_relaxed) == gen)
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
-        
-        return {};
+        auto &slot = _slots[idx];
+        if (get_generation(slot).load(std::memory_order_relaxed) == gen)
+            return std::ref(slot);
+
+        return slot_map_errc::stale_key;
     }
 
-    constexpr std::optional<std::reference_wrapper<slot_type>> get_slot(const key_type &key) noexcept
+    constexpr slot_map_result<std::reference_wrapper<slot_type>> get_slot(const key_type &key) noexcept
     {
-        try
-        {
-            const auto &[idx, gen] = key;
+        const auto &[idx, gen] = key;
+        if (unlikely(static_cast<size_t>(idx) > Size))
+            return slot_map_errc::out_of_range;
 
-            auto &slot = _slots[idx];
-            if (get_generation(slot).load(std::memory_order_relaxed) == gen)
-                return slot;
-        }
-        catch(const std::out_of_range &e) 
-        {}
+        auto &slot = _slots[idx];
+        if (get_generation(slot).load(std::memory_order_relaxed) == gen)
+            return std::ref(slot);
 
-        return {};
+        return slot_map_errc::stale_key;
     }
 
     bool addToEraseQueue(const key_type &key)
     {
         if (validate_and_increment_slot(key))
         {
-            size_t idx {};
-            do
-            {
-                idx = _erase_array_length.load(std::memory_order_acquire);
-                _erase_array[idx] = get_index(key);
-            }
-            while (!_erase_array_length.compare_exchange_strong(idx, idx+1));
-            _erase_array[idx] = get_index(key);
+            const size_t idx = _erase_array_length.fetch_add(1, std::memory_order_acq_rel);
+            publish_erase_entry(_erase_array[idx], get_index(key));
+            _stats.erase_queued(idx+1);
+            GBY_SLOT_MAP_PROBE(erase_enqueue, this, get_index(key), idx+1);
 
+            // a waiting inserter can drain the queue itself
+            wakeWaitingInserters();
             return true;
         }
         return false;
@@ -304,18 +354,25 @@ public:
     // should only ever be called by drainEraseQueue - don't call this directly.
     void drainEraseQueueImpl()
     {
+        GBY_SLOT_MAP_PROBE(drain_begin, this);
+        trace_span span {"drain", "elements"};
+
         if (_erase_array_length.load(std::memory_order_acquire) == 0)
+        {
+            _stats.drained(0);
+            GBY_SLOT_MAP_PROBE(drain_end, this, 0);
             return;
+        }
 
         size_t cur_erase_array_length {};
         size_t erase_idx {};
-        do
+        while (true)
         {
             cur_erase_array_length = _erase_array_length.load(std::memory_order_acquire);
 
             for ( ; erase_idx < cur_erase_array_length; ++erase_idx)
             {
-                const size_t slot_to_erase_idx = _erase_array[erase_idx];
+                const size_t slot_to_erase_idx = take_erase_entry(_erase_array[erase_idx]);
                 slot_type &slot_to_erase = _slots[slot_to_erase_idx];
                 size_t data_idx_to_free = get_index(slot_to_erase);
 
@@ -337,22 +394,162 @@ public:
                 set_index(_slots[previous_sentinel], slot_to_erase_idx);
                 _sentinel_last_slot_index.store(slot_to_erase_idx, std::memory_order_release);
             }
+
+            if (_erase_array_length.compare_exchange_strong(cur_erase_array_length, 0))
+                break;
+            _stats.cas_failure(cas_site::drain);
         }
-        while (!_erase_array_length.compare_exchange_strong(cur_erase_array_length, 0));
         assert(cur_erase_array_length == erase_idx);
+        _stats.drained(erase_idx);
+        span.set_arg(erase_idx);
+        GBY_SLOT_MAP_PROBE(drain_end, this, erase_idx);
+
+        wakeWaitingInserters();
     }
 
+    template<class ... Args>
+    std::optional<key_type> tryEmplaceImpl(const size_t max_attempts_, Args&& ... args)
+    {
+        GBY_SLOT_MAP_PROBE(insert_start, this);
+
+        slot_index_type cur_slot_idx {};
+        slot_type* cur_slot {};
+        {
+            std::shared_lock lg {_eraseMut, std::defer_lock};
+            _stats.lock(lg);
+
+            const auto acquired_slot_idx = acquireSlot(max_attempts_);
+            if (unlikely(!acquired_slot_idx))
+            {
+                GBY_SLOT_MAP_PROBE(insert_end, this, -1);
+                return {};
+            }
+            cur_slot_idx = *acquired_slot_idx;
+
+            slot_index_type cur_value_idx = _size.fetch_add(1, std::memory_order_acq_rel);
+
+            _data[cur_value_idx] = std::forward<Args...>(args...);
+
+            cur_slot = &_slots[cur_slot_idx]; 
+            set_index(*cur_slot, cur_value_idx);
+            _reverse_array[cur_value_idx] = cur_slot_idx;            
+
+            // publish as many fully written elements as we can. If the next element
+            // isn't written yet, its writer will publish it (and the ones after it).
+            slot_index_type conservSize{};
+            backoff publishBo;
+            while (true)
+            {
+                conservSize = _conservative_size.load(std::memory_order_acquire);
+                if (conservSize >= _size.load(std::memory_order_acquire) ||
+                    get_index(_slots[_reverse_array[conservSize]]) != conservSize)
+                    break;
+
+                if (!_conservative_size.compare_exchange_strong(conservSize, conservSize+1))
+                {
+                    _stats.cas_failure(cas_site::publish);
+                    publishBo.pause();
+                }
+            }
+        }        
 
-    std::vector<slot_type> _slots = std::vector<slot_type>(Size+1); // +1 for sentinel
+        GBY_SLOT_MAP_PROBE(insert_end, this, cur_slot_idx);
+        return key_type{cur_slot_idx, get_generation(*cur_slot).load(std::memory_order_acquire)};       
+    }
+
+    // a recycled slot off the free list if there is one (it's still warm in
+    // cache), otherwise the next fresh one. Empty if the map is full, or once
+    // max_attempts_ compare-exchanges in a row lost to other inserters.
+    // Only called under a shared hold of _eraseMut, which keeps out the drains
+    // pushing slots back onto the free list - else the head could be popped
+    // and pushed back between reading its link and the compare-exchange, and
+    // the exchange would install a stale link (ABA).
+    std::optional<slot_index_type> acquireSlot(const size_t max_attempts_ = unbounded_attempts)
+    {
+        backoff bo;
+        for (size_t attempt = 1; ; ++attempt)
+        {
+            slot_index_type cur_slot_idx = _next_available_slot_index.load(std::memory_order_acquire);
+            if (cur_slot_idx != _sentinel_last_slot_index.load(std::memory_order_acquire))
+            {
+                if (_next_available_slot_index.compare_exchange_strong(cur_slot_idx, get_index<slot_type>(_slots[cur_slot_idx])))
+                    return cur_slot_idx;
+                _stats.cas_failure(cas_site::free_list);
+                GBY_SLOT_MAP_PROBE(free_list_cas_retry, this);
+            }
+            else
+            {
+                // fresh slots are zeroed and never linked, so claiming one is all it takes
+                slot_index_type fresh_slot_idx = _fresh_slot_index.load(std::memory_order_relaxed);
+                if (unlikely(static_cast<size_t>(fresh_slot_idx) > Size))
+                    return {};
+
+                if (_fresh_slot_index.compare_exchange_strong(fresh_slot_idx, fresh_slot_idx+1, std::memory_order_relaxed))
+                    return fresh_slot_idx;
+                _stats.cas_failure(cas_site::fresh_slot);
+            }
+
+            if (attempt == max_attempts_)
+                return {};
+            bo.pause();
+        }
+    }
+
+    // deadline_ of std::nullopt waits indefinitely. Must not be called from within iterate_map.
+    template<class ... Args>
+    std::optional<key_type> emplaceUntil(const std::optional<std::chrono::steady_clock::time_point> deadline_, Args&& ... args)
+    {
+        std::optional<key_type> key {};
+        _waiting_inserters.fetch_add(1, std::memory_order_seq_cst);
+        while (true)
+        {
+            const auto free_epoch = _free_epoch.load(std::memory_order_acquire);
+            if ((key = try_emplace(std::forward<Args>(args)...)))
+                break;
+
+            // erased slots are only freed once drained, so don't wait on a drain that might not come
+            if (_erase_array_length.load(std::memory_order_seq_cst) > 0)
+            {
+                drainEraseQueue<true>();
+                continue;
+            }
+
+            if (!deadline_)
+                spin_then_park(_free_epoch, free_epoch);
+            else if (!spin_then_wait_until(_free_epoch, free_epoch, *deadline_))
+                break;
+        }
+        _waiting_inserters.fetch_sub(1, std::memory_order_relaxed);
+
+        return key;
+    }
+
+    void wakeWaitingInserters()
+    {
+        // pairs with the seq_cst increment of _waiting_inserters, so that either we
+        // see the waiter or the waiter sees the erased element/freed slot.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_waiting_inserters.load(std::memory_order_relaxed) > 0)
+        {
+            _free_epoch.fetch_add(1, std::memory_order_acq_rel);
+            _free_epoch.notify_all();
+        }
+    }
+
+
+    std::vector<slot_type, zeroed_allocator<slot_type>> _slots = decltype(_slots)(Size+1); // +1 for sentinel
     container_type         _data = container_type(Size+1);
-    std::vector<size_t>    _reverse_array = std::vector<size_t>(Size+1);
+    std::vector<size_t, zeroed_allocator<size_t>> _reverse_array = decltype(_reverse_array)(Size+1);
 
-    // free list used to keep track of the available slots in the slot array
+    // free list of the recycled slots in the slot array
     std::atomic<key_index_type> _next_available_slot_index;
     std::atomic<key_index_type> _sentinel_last_slot_index;
+
+    // high-water mark of the slots ever used: the slots from here to Size are fresh
+    std::atomic<key_index_type> _fresh_slot_index {1};
     
     // stack used to store elements to be deleted.
-    std::vector<slot_index_type> _erase_array = std::vector<slot_index_type>(Size);
+    std::vector<slot_index_type, zeroed_allocator<slot_index_type>> _erase_array = decltype(_erase_array)(Size);
     std::atomic<size_t>  _erase_array_length;
 
 
@@ -363,6 +560,14 @@ public:
     std::atomic<slot_index_type> _conservative_size;
 
     std::shared_mutex _eraseMut;
+
+    // used by insert_wait/try_insert_for to wait on a full map. _free_epoch is
+    // bumped (only if someone is waiting) whenever an erase is queued or drained.
+    std::atomic<size_t>   _waiting_inserters {};
+    std::atomic<uint32_t> _free_epoch {};
+
+    using cas_site = slot_map_counters::cas_site;
+    [[no_unique_address]] slot_map_counters _stats;
 };
 
 } // namespace gby
@@ -0,0 +1,45 @@
+/*
+ * slot_map_probes.h - USDT (user statically defined tracing) probes in the
+ * slot maps' hot paths, for attaching bpftrace/perf/systemtap to a running
+ * process without rebuilding it.
+ *
+ * Compiled in only when GBY_SLOT_MAP_USDT is defined (the CMake option
+ * GBY_SLOTMAP_USDT), which needs <sys/sdt.h> (systemtap-sdt-dev). A probe is
+ * then a single nop in the code plus a note in the binary's .note.stapsdt
+ * section, until a tracer attaches to it. Otherwise the probes are empty.
+ *
+ * All probes are under the provider gby_slot_map, and all take the map's
+ * address as their first argument, to tell the maps of a process apart:
+ *
+ *   insert_start  (map)
+ *   insert_end    (map, slot index)                  slot index is -1 if the map was full
+ *   free_list_cas_retry (map)                        a lost race for the free list's head
+ *   erase_enqueue (map, slot index, queue depth)
+ *   drain_begin   (map)                              holding the erase lock
+ *   drain_end     (map, elements drained)
+ *   grow_begin    (map, old capacity, new capacity)  dynamic_slot_map only
+ *   grow_end      (map, new capacity)
+ *   iterate_begin (map)                              holding the iteration lock
+ *   iterate_end   (map)
+ *
+ * test/benchmarks/drain_latency.bt is an example, timing the drains of a
+ * running benchmark.
+ */
+
+#pragma once
+
+#if defined(GBY_SLOT_MAP_USDT)
+
+#if !__has_include(<sys/sdt.h>)
+#error "GBY_SLOT_MAP_USDT needs <sys/sdt.h>, install systemtap-sdt-dev (or systemtap-sdt-devel)"
+#endif
+
+#include <sys/sdt.h>
+
+#define GBY_SLOT_MAP_PROBE(name, ...) STAP_PROBEV(gby_slot_map, name, __VA_ARGS__)
+
+#else
+
+#define GBY_SLOT_MAP_PROBE(name, ...) ((void)0)
+
+#endif
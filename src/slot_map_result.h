@@ -0,0 +1,76 @@
+/*
+ * slot_map_result.h - What the slot maps' exception-free lookup() and
+ * insert_nothrow() return: either the value, or why there isn't one. It's a
+ * small stand-in for C++23's std::expected, with the maps' own error codes.
+ *
+ * Nothing in here throws or allocates, so those calls work the same in code
+ * built with -fno-exceptions, and a failed lookup is an ordinary (and
+ * predictable) branch for the caller rather than an unwind.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <optional>
+#include <utility>
+
+namespace gby
+{
+
+enum class slot_map_errc : unsigned char
+{
+    out_of_range = 1,  // the key's index is past the map's slots
+    stale_key,         // the key's element has been erased (or the key was never handed out)
+    full               // no slot was free, or none could be claimed within the attempts given
+};
+
+constexpr const char* to_string(const slot_map_errc errc_) noexcept
+{
+    switch (errc_)
+    {
+        case slot_map_errc::out_of_range: return "key index out of range";
+        case slot_map_errc::stale_key:    return "stale key";
+        case slot_map_errc::full:         return "slot map full";
+    }
+    return "unknown slot map error";
+}
+
+template<typename T>
+class slot_map_result
+{
+public:
+    using value_type = T;
+    using error_type = slot_map_errc;
+
+    constexpr slot_map_result(T value_) noexcept
+            : _value {std::move(value_)}
+    {}
+
+    constexpr slot_map_result(const slot_map_errc error_) noexcept
+            : _error {error_}
+    {}
+
+    constexpr bool has_value()       const noexcept { return _value.has_value(); }
+    constexpr explicit operator bool() const noexcept { return has_value(); }
+
+    // only valid if has_value()
+    constexpr T&       value()       noexcept { assert(has_value()); return *_value; }
+    constexpr const T& value() const noexcept { assert(has_value()); return *_value; }
+
+    constexpr T&       operator*()       noexcept { return value(); }
+    constexpr const T& operator*() const noexcept { return value(); }
+    constexpr T*       operator->()       noexcept { return &value(); }
+    constexpr const T* operator->() const noexcept { return &value(); }
+
+    template<typename U>
+    constexpr T value_or(U&& default_) const noexcept { return _value.value_or(std::forward<U>(default_)); }
+
+    // only valid if !has_value()
+    constexpr slot_map_errc error() const noexcept { assert(!has_value()); return _error; }
+
+private:
+    std::optional<T> _value {};
+    slot_map_errc    _error {};
+};
+
+} // namespace gby
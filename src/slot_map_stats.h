@@ -0,0 +1,233 @@
+/*
+ * slot_map_stats.h - Contention and operation counters of the concurrent
+ * slot maps, to tell from the outside why a run is slow: CAS retries, drains
+ * that couldn't get the lock, long erase backlogs, growth and lock waits.
+ *
+ * Compiled in only when GBY_SLOT_MAP_STATS is defined (the CMake option
+ * GBY_SLOTMAP_STATS). Otherwise slot_map_counters is an empty class whose
+ * methods do nothing, and stats() returns all zeros.
+ *
+ * The counters are sharded: every thread counts into one of
+ * slot_map_counters::SHARDS cache line sized shards, picked once per thread,
+ * so counting doesn't add a contended cache line of its own to the map.
+ */
+
+#pragma once
+
+#include "slot_map_trace.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace gby
+{
+
+// snapshot of a map's counters, the sum over all threads since construction
+struct slot_map_stats
+{
+    // failed compare-exchanges, per site
+    uint64_t free_list_cas_failures   {};  // popping a recycled slot off the free list
+    uint64_t fresh_slot_cas_failures  {};  // claiming a fresh slot
+    uint64_t size_cas_failures        {};  // reserving/releasing a data index (lock_free_const_sized_slot_map)
+    uint64_t publish_cas_failures     {};  // advancing _conservative_size (optimized_locked_slot_map)
+    uint64_t drain_restarts           {};  // a drain finding more erases queued by the time it was done
+
+    uint64_t drains_attempted         {};  // including those that gave up on a busy lock
+    uint64_t drains_succeeded         {};
+    uint64_t elements_drained         {};
+    uint64_t max_elements_per_drain   {};
+    uint64_t peak_erase_queue_depth   {};
+
+    uint64_t growth_events            {};  // dynamic_slot_map
+    uint64_t erase_lock_waits         {};  // acquisitions of the erase/iteration lock that had to wait
+    uint64_t erase_lock_wait_ns       {};  // time spent in those
+
+    double elements_per_drain() const
+    {
+        return drains_succeeded == 0 ? 0 : static_cast<double>(elements_drained) / drains_succeeded;
+    }
+};
+
+#if defined(GBY_SLOT_MAP_STATS)
+
+class slot_map_counters
+{
+public:
+    static constexpr bool   enabled = true;
+    static constexpr size_t SHARDS  = 16;
+
+    enum class cas_site
+    {
+        free_list,
+        fresh_slot,
+        size,
+        publish,
+        drain
+    };
+
+    void cas_failure(const cas_site site_) noexcept
+    {
+        auto& shard = current_shard();
+        switch (site_)
+        {
+            case cas_site::free_list:   add(shard.free_list_cas_failures);   break;
+            case cas_site::fresh_slot:  add(shard.fresh_slot_cas_failures);  break;
+            case cas_site::size:        add(shard.size_cas_failures);        break;
+            case cas_site::publish:     add(shard.publish_cas_failures);     break;
+            case cas_site::drain:       add(shard.drain_restarts);           break;
+        }
+    }
+
+    void drain_attempted() noexcept { add(current_shard().drains_attempted); }
+
+    void drained(const uint64_t elements_) noexcept
+    {
+        auto& shard = current_shard();
+        add(shard.drains_succeeded);
+        add(shard.elements_drained, elements_);
+        raise(shard.max_elements_per_drain, elements_);
+    }
+
+    void erase_queued(const uint64_t depth_) noexcept { raise(current_shard().peak_erase_queue_depth, depth_); }
+
+    void grew() noexcept { add(current_shard().growth_events); }
+
+    // locks lock_, timing how long it took if it couldn't be taken right away
+    template<class Lock>
+    void lock(Lock& lock_)
+    {
+        if (lock_.try_lock())
+            return;
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            trace_span span {"erase lock wait"};
+            lock_.lock();
+        }
+        const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        auto& shard = current_shard();
+        add(shard.erase_lock_waits);
+        add(shard.erase_lock_wait_ns, static_cast<uint64_t>(waited.count()));
+    }
+
+    slot_map_stats snapshot() const noexcept
+    {
+        slot_map_stats stats {};
+        for (const auto& shard : _shards)
+        {
+            stats.free_list_cas_failures   += load(shard.free_list_cas_failures);
+            stats.fresh_slot_cas_failures  += load(shard.fresh_slot_cas_failures);
+            stats.size_cas_failures        += load(shard.size_cas_failures);
+            stats.publish_cas_failures     += load(shard.publish_cas_failures);
+            stats.drain_restarts           += load(shard.drain_restarts);
+            stats.drains_attempted         += load(shard.drains_attempted);
+            stats.drains_succeeded         += load(shard.drains_succeeded);
+            stats.elements_drained         += load(shard.elements_drained);
+            stats.growth_events            += load(shard.growth_events);
+            stats.erase_lock_waits         += load(shard.erase_lock_waits);
+            stats.erase_lock_wait_ns       += load(shard.erase_lock_wait_ns);
+
+            if (const auto max = load(shard.max_elements_per_drain); max > stats.max_elements_per_drain)
+                stats.max_elements_per_drain = max;
+            if (const auto peak = load(shard.peak_erase_queue_depth); peak > stats.peak_erase_queue_depth)
+                stats.peak_erase_queue_depth = peak;
+        }
+        return stats;
+    }
+
+private:
+    using counter = std::atomic<uint64_t>;
+
+    struct alignas(64) shard
+    {
+        counter free_list_cas_failures   {};
+        counter fresh_slot_cas_failures  {};
+        counter size_cas_failures        {};
+        counter publish_cas_failures     {};
+        counter drain_restarts           {};
+        counter drains_attempted         {};
+        counter drains_succeeded         {};
+        counter elements_drained         {};
+        counter max_elements_per_drain   {};
+        counter peak_erase_queue_depth   {};
+        counter growth_events            {};
+        counter erase_lock_waits         {};
+        counter erase_lock_wait_ns       {};
+    };
+
+    // threads are spread over the shards in the order they first count anything
+    shard& current_shard() noexcept
+    {
+        static std::atomic<size_t> next_thread {};
+        thread_local const size_t thread_shard = next_thread.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return _shards[thread_shard];
+    }
+
+    // a shard is only ever shared by a few threads, relaxed RMWs on it are cheap
+    static void add(counter& counter_, const uint64_t value_ = 1) noexcept
+    {
+        counter_.fetch_add(value_, std::memory_order_relaxed);
+    }
+
+    static void raise(counter& counter_, const uint64_t value_) noexcept
+    {
+        uint64_t cur = counter_.load(std::memory_order_relaxed);
+        while (value_ > cur && !counter_.compare_exchange_weak(cur, value_, std::memory_order_relaxed))
+            ;
+    }
+
+    static uint64_t load(const counter& counter_) noexcept
+    {
+        return counter_.load(std::memory_order_relaxed);
+    }
+
+    std::array<shard, SHARDS> _shards {};
+};
+
+#else
+
+class slot_map_counters
+{
+public:
+    static constexpr bool enabled = false;
+
+    enum class cas_site
+    {
+        free_list,
+        fresh_slot,
+        size,
+        publish,
+        drain
+    };
+
+    void cas_failure(cas_site) noexcept {}
+    void drain_attempted() noexcept {}
+    void drained(uint64_t) noexcept {}
+    void erase_queued(uint64_t) noexcept {}
+    void grew() noexcept {}
+
+    // a wait for the lock is still traced, if the trace is compiled in
+    template<class Lock>
+    void lock(Lock& lock_)
+    {
+        if constexpr (trace_span::enabled)
+        {
+            if (lock_.try_lock())
+                return;
+            trace_span span {"erase lock wait"};
+            lock_.lock();
+        }
+        else
+            lock_.lock();
+    }
+
+    slot_map_stats snapshot() const noexcept { return {}; }
+};
+
+#endif
+
+} // namespace gby
@@ -0,0 +1,275 @@
+/*
+ * slot_map_trace.h - A timeline of what the threads using the slot maps were
+ * doing, written as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev)
+ * to see how operations, lock waits, drains and growth interleaved.
+ *
+ * Compiled in only when GBY_SLOT_MAP_TRACE is defined (the CMake option
+ * GBY_SLOTMAP_TRACE). Otherwise trace_span is an empty class and nothing is
+ * recorded.
+ *
+ * Every thread records its spans into a buffer of its own: chunks of
+ * trace_log::CHUNK_EVENTS events that are appended to and linked by that
+ * thread alone, and published with release stores, so recording takes no
+ * locks and the buffers may be read while being written to. The maps record
+ * their drains, their growth and the waits for the erase/iteration lock; the
+ * harness (or any other user) records its own spans around the operations.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gby
+{
+
+#if defined(GBY_SLOT_MAP_TRACE)
+
+class trace_log
+{
+public:
+    static constexpr size_t   CHUNK_EVENTS = 4096;
+    static constexpr uint64_t NO_ARG       = std::numeric_limits<uint64_t>::max();
+
+    struct event
+    {
+        const char* name;
+        const char* arg_name;
+        uint64_t    start_ns;
+        uint64_t    end_ns;
+        uint64_t    arg;
+    };
+
+    // the process wide log
+    static trace_log& instance()
+    {
+        static trace_log log;
+        return log;
+    }
+
+    static uint64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // names and arg names must be string literals, or otherwise outlive the log
+    void record(const event& event_) { current_buffer().append(event_); }
+
+    // shown as the calling thread's name in the timeline
+    void set_thread_name(std::string name_)
+    {
+        auto& buffer = current_buffer();
+        std::lock_guard lg {_buffers_lock};
+        buffer.name = std::move(name_);
+    }
+
+    // drops everything recorded so far, and the buffers of the threads that
+    // are gone. Must not be called while anyone is recording.
+    void clear()
+    {
+        std::lock_guard lg {_buffers_lock};
+        std::erase_if(_buffers, [](const auto& buffer) { return buffer->retired.load(std::memory_order_acquire); });
+        for (auto& buffer : _buffers)
+            buffer->reset();
+    }
+
+    // may be called while threads are still recording, their latest spans
+    // might be left out
+    void write_chrome_trace(std::ostream& os_) const
+    {
+        std::lock_guard lg {_buffers_lock};
+
+        uint64_t origin = std::numeric_limits<uint64_t>::max();
+        for (const auto& buffer : _buffers)
+            buffer->for_each([&origin](const event& event_) { origin = std::min(origin, event_.start_ns); });
+
+        // the format's timestamps are in microseconds
+        const auto micros = [](const uint64_t ns_) { return std::to_string(ns_ / 1000) + '.' + pad3(ns_ % 1000); };
+
+        const char* separator = "";
+        os_ << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+        for (const auto& buffer : _buffers)
+        {
+            os_ << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+                << ", \"args\": {\"name\": \"" << (buffer->name.empty() ? "thread" : buffer->name) << "\"}}";
+            separator = ",\n";
+
+            buffer->for_each([&](const event& event_) {
+                os_ << separator << "{\"name\": \"" << event_.name << "\", \"cat\": \"gby\", \"ph\": \"X\", \"pid\": 1"
+                    << ", \"tid\": " << buffer->tid
+                    << ", \"ts\": "  << micros(event_.start_ns - origin)
+                    << ", \"dur\": " << micros(event_.end_ns - event_.start_ns);
+                if (event_.arg != NO_ARG)
+                    os_ << ", \"args\": {\"" << event_.arg_name << "\": " << event_.arg << '}';
+                os_ << '}';
+            });
+        }
+        os_ << "\n]}\n";
+    }
+
+    bool write_chrome_trace(const std::string& path_) const
+    {
+        std::ofstream file {path_, std::ios::trunc};
+        write_chrome_trace(file);
+        return static_cast<bool>(file.flush());
+    }
+
+private:
+    struct chunk
+    {
+        std::array<event, CHUNK_EVENTS> events;
+        std::atomic<size_t>             count {};
+        std::atomic<chunk*>             next  {};
+    };
+
+    struct buffer
+    {
+        explicit buffer(const size_t tid_)
+                : tid {tid_}
+        {}
+
+        ~buffer()
+        {
+            for (chunk* cur = head.next.load(std::memory_order_relaxed); cur; )
+            {
+                chunk* next = cur->next.load(std::memory_order_relaxed);
+                delete cur;
+                cur = next;
+            }
+        }
+
+        // only ever called by the buffer's thread
+        void append(const event& event_)
+        {
+            size_t count = tail->count.load(std::memory_order_relaxed);
+            if (count == CHUNK_EVENTS)
+            {
+                chunk* next = tail->next.load(std::memory_order_relaxed);
+                if (!next)
+                {
+                    next = new chunk;
+                    tail->next.store(next, std::memory_order_release);
+                }
+                tail  = next;
+                count = 0;
+            }
+            tail->events[count] = event_;
+            tail->count.store(count + 1, std::memory_order_release);
+        }
+
+        template<class Fnc>
+        void for_each(Fnc&& fnc_) const
+        {
+            for (const chunk* cur = &head; cur; cur = cur->next.load(std::memory_order_acquire))
+            {
+                const size_t count = cur->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i)
+                    fnc_(cur->events[i]);
+            }
+        }
+
+        // keeps the chunks, for the next recording to reuse
+        void reset()
+        {
+            for (chunk* cur = &head; cur; cur = cur->next.load(std::memory_order_relaxed))
+                cur->count.store(0, std::memory_order_relaxed);
+            tail = &head;
+        }
+
+        const size_t      tid;
+        std::string       name;
+        chunk             head;
+        chunk*            tail {&head};
+        std::atomic<bool> retired {};
+    };
+
+    // marks the thread's buffer retired on thread exit, clear() frees it
+    struct buffer_owner
+    {
+        std::shared_ptr<buffer> buf;
+        ~buffer_owner() { if (buf) buf->retired.store(true, std::memory_order_release); }
+    };
+
+    buffer& current_buffer()
+    {
+        thread_local buffer_owner owner;
+        if (!owner.buf)
+        {
+            std::lock_guard lg {_buffers_lock};
+            owner.buf = std::make_shared<buffer>(++_next_tid);
+            _buffers.push_back(owner.buf);
+        }
+        return *owner.buf;
+    }
+
+    static std::string pad3(const uint64_t val_)
+    {
+        std::string str = std::to_string(val_);
+        return std::string(3 - str.size(), '0') + str;
+    }
+
+    mutable std::mutex                   _buffers_lock;
+    std::vector<std::shared_ptr<buffer>> _buffers;
+    size_t                               _next_tid {};
+};
+
+// records the time from its construction to its destruction as a span
+class trace_span
+{
+public:
+    static constexpr bool enabled = true;
+
+    explicit trace_span(const char* name_, const char* arg_name_ = nullptr) noexcept
+            : _name {name_}
+            , _arg_name {arg_name_}
+            , _start {trace_log::now_ns()}
+    {}
+
+    trace_span(const trace_span&) = delete;
+    trace_span& operator=(const trace_span&) = delete;
+
+    ~trace_span()
+    {
+        trace_log::instance().record({_name, _arg_name, _start, trace_log::now_ns(), _arg_name ? _arg : trace_log::NO_ARG});
+    }
+
+    void set_arg(const uint64_t arg_) noexcept { _arg = arg_; }
+
+private:
+    const char*    _name;
+    const char*    _arg_name;
+    const uint64_t _start;
+    uint64_t       _arg {};
+};
+
+inline void trace_thread_name(std::string name_) { trace_log::instance().set_thread_name(std::move(name_)); }
+
+#else
+
+class trace_span
+{
+public:
+    static constexpr bool enabled = false;
+
+    explicit trace_span(const char*, const char* = nullptr) noexcept {}
+
+    void set_arg(uint64_t) noexcept {}
+};
+
+inline void trace_thread_name(const std::string&) {}
+
+#endif
+
+} // namespace gby
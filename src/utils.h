@@ -1,7 +1,14 @@
 
 #pragma once
 
+#include "backoff.h"
+
 #include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <utility>
 
 namespace gby
 {
@@ -9,6 +16,19 @@ namespace gby
 #define likely(x)      __builtin_expect(!!(x), 1)
 #define unlikely(x)    __builtin_expect(!!(x), 0)
 
+// Throws Exception(args...), or aborts when built with -fno-exceptions. Kept
+// cold and out of line, so the throwing paths stay out of the callers' hot code.
+template<typename Exception, typename... Args>
+[[noreturn, gnu::cold, gnu::noinline]] void throw_or_abort(Args&&... args)
+{
+#if defined(__cpp_exceptions)
+    throw Exception(std::forward<Args>(args)...);
+#else
+    ((void)args, ...);
+    std::abort();
+#endif
+}
+
 template<typename T> 
 auto constexpr is_atomic = false;
 
@@ -42,4 +62,84 @@ auto constexpr is_not_atomic = true;
 template<typename T>
 auto constexpr is_not_atomic<std::atomic<T>> = false;
 
+// The erase queues' entries. An eraser claims an entry by bumping the queue's
+// length and only then writes it, so a drain may come across an entry that is
+// claimed but not written yet. Entries hold the slot index + 1, zero meaning
+// not written, and the drain waits for them and zeroes them for reuse.
+template<typename Index>
+void publish_erase_entry(Index& entry_, const size_t slot_idx_) noexcept
+{
+    std::atomic_ref<Index> {entry_}.store(static_cast<Index>(slot_idx_ + 1), std::memory_order_release);
+}
+
+template<typename Index>
+size_t take_erase_entry(Index& entry_) noexcept
+{
+    std::atomic_ref<Index> entry {entry_};
+    Index value {};
+    backoff bo;
+    while ((value = entry.exchange(0, std::memory_order_acquire)) == 0)
+        bo.pause();
+    return static_cast<size_t>(value - 1);
+}
+
+// Tag to construct a dynamic_slot_map in real-time mode: everything is
+// allocated up front and the map never grows - inserts into a full map fail
+// rather than allocate.
+struct real_time_t { explicit real_time_t() = default; };
+inline constexpr real_time_t real_time {};
+
+// The compare-exchanges a bounded try_insert makes at the most to claim a slot
+// before it gives up, rather than keep retrying against the other inserters.
+inline constexpr size_t default_try_attempts = 64;
+inline constexpr size_t unbounded_attempts   = std::numeric_limits<size_t>::max();
+
+// Heap bytes a slot map has allocated, per component, whether in use or not.
+// Memory the elements own themselves (e.g. a std::string's buffer) and the
+// map object itself aren't included.
+struct memory_usage_breakdown
+{
+    size_t slots         {};
+    size_t data          {};
+    size_t reverse_array {};
+    size_t erase_queue   {};
+    size_t bucket_slack  {};  // internal_vector buckets allocated beyond the map's capacity
+
+    constexpr size_t total() const { return slots + data + reverse_array + erase_queue + bucket_slack; }
+};
+
+// Allocator for the bookkeeping arrays (slots, indices) whose value-initialized
+// elements are all zero bits. The memory comes zeroed from calloc - for large
+// arrays as fresh pages straight from the OS - so value-initializing it is a
+// no-op and pages that are never used are never touched.
+template<typename T>
+struct zeroed_allocator
+{
+    using value_type = T;
+
+    zeroed_allocator() noexcept = default;
+
+    template<typename U>
+    constexpr zeroed_allocator(const zeroed_allocator<U>&) noexcept {}
+
+    T* allocate(const size_t n)
+    {
+        if (auto ptr = static_cast<T*>(std::calloc(n, sizeof(T))))
+            return ptr;
+        throw_or_abort<std::bad_alloc>();
+    }
+
+    void deallocate(T* ptr, size_t) noexcept { std::free(ptr); }
+
+    // already zero
+    template<typename U>
+    void construct(U*) noexcept {}
+
+    template<typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) { ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...); }
+
+    template<typename U>
+    friend bool operator==(const zeroed_allocator&, const zeroed_allocator<U>&) noexcept { return true; }
+};
+
 } // namespace gby
\ No newline at end of file
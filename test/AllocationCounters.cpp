@@ -0,0 +1,226 @@
+
+// Replaces the global operator new/delete and interposes the malloc family, so
+// that every heap allocation of the process is counted to the thread making it.
+// Only linked in with GBY_SLOTMAP_COUNT_ALLOCATIONS and into the real-time
+// tests, see AllocationCounters.h.
+//
+// With glibc the allocations are forwarded to its __libc_* entry points, so
+// an operator new is counted once rather than once more by the malloc under it.
+// Elsewhere only operator new/delete are replaced and forward to std::malloc.
+
+#include "AllocationCounters.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void  __libc_free(void* ptr);
+}
+#endif
+
+namespace
+{
+    // constant initialized, so touching them never allocates
+    thread_local AllocationCounts threadCounts {};
+    thread_local bool             paused {false};
+
+    void countAllocation(const size_t bytes_)
+    {
+        if (!paused)
+        {
+            ++threadCounts.allocations;
+            threadCounts.bytes += bytes_;
+        }
+    }
+
+    void countDeallocation(const void* ptr_)
+    {
+        if (ptr_ && !paused)
+            ++threadCounts.deallocations;
+    }
+
+    void* rawMalloc(const size_t size_)
+    {
+#if defined(__GLIBC__)
+        return __libc_malloc(size_);
+#else
+        return std::malloc(size_);
+#endif
+    }
+
+    void* rawAlignedMalloc(const size_t size_, const size_t alignment_)
+    {
+#if defined(__GLIBC__)
+        return __libc_memalign(alignment_, size_);
+#else
+        // aligned_alloc wants a multiple of the alignment
+        return std::aligned_alloc(alignment_, (size_ + alignment_ - 1) / alignment_ * alignment_);
+#endif
+    }
+
+    void rawFree(void* ptr_)
+    {
+#if defined(__GLIBC__)
+        __libc_free(ptr_);
+#else
+        std::free(ptr_);
+#endif
+    }
+
+    // operator new's contract: retry through the new handler, throw once there is none
+    template<typename Alloc>
+    void* newOrThrow(const size_t size_, Alloc alloc_)
+    {
+        const size_t size = size_ ? size_ : 1;
+        while (true)
+        {
+            if (void* ptr = alloc_(size))
+            {
+                countAllocation(size_);
+                return ptr;
+            }
+            auto handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* newPlain(const size_t size_)
+    {
+        return newOrThrow(size_, rawMalloc);
+    }
+
+    void* newAligned(const size_t size_, const std::align_val_t alignment_)
+    {
+        return newOrThrow(size_, [=](const size_t size) {
+            return rawAlignedMalloc(size, static_cast<size_t>(alignment_));
+        });
+    }
+
+    void deleteAny(void* ptr_) noexcept
+    {
+        countDeallocation(ptr_);
+        rawFree(ptr_);
+    }
+}
+
+AllocationCounts threadAllocationCounts()
+{
+    return threadCounts;
+}
+
+void pauseAllocationCounting()
+{
+    paused = true;
+}
+
+void resumeAllocationCounting()
+{
+    paused = false;
+}
+
+
+void* operator new  (size_t size_) { return newPlain(size_); }
+void* operator new[](size_t size_) { return newPlain(size_); }
+void* operator new  (size_t size_, std::align_val_t al_) { return newAligned(size_, al_); }
+void* operator new[](size_t size_, std::align_val_t al_) { return newAligned(size_, al_); }
+
+void* operator new  (size_t size_, const std::nothrow_t&) noexcept
+{
+    try { return newPlain(size_); } catch (const std::bad_alloc&) { return nullptr; }
+}
+void* operator new[](size_t size_, const std::nothrow_t&) noexcept
+{
+    try { return newPlain(size_); } catch (const std::bad_alloc&) { return nullptr; }
+}
+void* operator new  (size_t size_, std::align_val_t al_, const std::nothrow_t&) noexcept
+{
+    try { return newAligned(size_, al_); } catch (const std::bad_alloc&) { return nullptr; }
+}
+void* operator new[](size_t size_, std::align_val_t al_, const std::nothrow_t&) noexcept
+{
+    try { return newAligned(size_, al_); } catch (const std::bad_alloc&) { return nullptr; }
+}
+
+void operator delete  (void* ptr_) noexcept { deleteAny(ptr_); }
+void operator delete[](void* ptr_) noexcept { deleteAny(ptr_); }
+void operator delete  (void* ptr_, size_t) noexcept { deleteAny(ptr_); }
+void operator delete[](void* ptr_, size_t) noexcept { deleteAny(ptr_); }
+void operator delete  (void* ptr_, std::align_val_t) noexcept { deleteAny(ptr_); }
+void operator delete[](void* ptr_, std::align_val_t) noexcept { deleteAny(ptr_); }
+void operator delete  (void* ptr_, size_t, std::align_val_t) noexcept { deleteAny(ptr_); }
+void operator delete[](void* ptr_, size_t, std::align_val_t) noexcept { deleteAny(ptr_); }
+void operator delete  (void* ptr_, const std::nothrow_t&) noexcept { deleteAny(ptr_); }
+void operator delete[](void* ptr_, const std::nothrow_t&) noexcept { deleteAny(ptr_); }
+void operator delete  (void* ptr_, std::align_val_t, const std::nothrow_t&) noexcept { deleteAny(ptr_); }
+void operator delete[](void* ptr_, std::align_val_t, const std::nothrow_t&) noexcept { deleteAny(ptr_); }
+
+
+#if defined(__GLIBC__)
+// the malloc family, for the allocations made around operator new: C code,
+// strdup, the C++ runtime's exception objects and the like
+extern "C"
+{
+    void* malloc(size_t size_) noexcept
+    {
+        void* ptr = __libc_malloc(size_);
+        if (ptr)
+            countAllocation(size_);
+        return ptr;
+    }
+
+    void* calloc(size_t count_, size_t size_) noexcept
+    {
+        void* ptr = __libc_calloc(count_, size_);
+        if (ptr)
+            countAllocation(count_ * size_);
+        return ptr;
+    }
+
+    // a move counts as an allocation plus a deallocation
+    void* realloc(void* ptr_, size_t size_) noexcept
+    {
+        void* ptr = __libc_realloc(ptr_, size_);
+        if (ptr)
+            countAllocation(size_);
+        if (ptr_ && (ptr || size_ == 0))
+            countDeallocation(ptr_);
+        return ptr;
+    }
+
+    void* memalign(size_t alignment_, size_t size_) noexcept
+    {
+        void* ptr = __libc_memalign(alignment_, size_);
+        if (ptr)
+            countAllocation(size_);
+        return ptr;
+    }
+
+    void* aligned_alloc(size_t alignment_, size_t size_) noexcept
+    {
+        return memalign(alignment_, size_);
+    }
+
+    int posix_memalign(void** ptr_, size_t alignment_, size_t size_) noexcept
+    {
+        if (alignment_ % sizeof(void*) != 0 || (alignment_ & (alignment_ - 1)) != 0)
+            return EINVAL;
+        *ptr_ = memalign(alignment_, size_);
+        return *ptr_ || size_ == 0 ? 0 : ENOMEM;
+    }
+
+    void free(void* ptr_) noexcept
+    {
+        countDeallocation(ptr_);
+        __libc_free(ptr_);
+    }
+}
+#endif
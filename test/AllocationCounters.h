@@ -0,0 +1,73 @@
+
+#pragma once
+
+// Heap allocations of the calling thread. Counting is opt-in: configuring with
+// -DGBY_SLOTMAP_COUNT_ALLOCATIONS=ON links AllocationCounters.cpp, which replaces
+// the global operator new/delete and interposes malloc and friends, into the
+// benchmarks and regression tests, and defines GBY_COUNT_ALLOCATIONS for them.
+// GBY_SlotMap_RealTimeTests always links it. Without it every count is 0 and
+// nothing is reported.
+
+#include <cstdint>
+#include <ostream>
+
+struct AllocationCounts
+{
+    uint64_t allocations   {};
+    uint64_t deallocations {};
+    uint64_t bytes         {};  // requested, not what the allocator rounds up to
+
+    AllocationCounts& operator+=(const AllocationCounts& other_)
+    {
+        allocations   += other_.allocations;
+        deallocations += other_.deallocations;
+        bytes         += other_.bytes;
+        return *this;
+    }
+
+    friend AllocationCounts operator-(const AllocationCounts& lhs_, const AllocationCounts& rhs_)
+    {
+        return {lhs_.allocations - rhs_.allocations, lhs_.deallocations - rhs_.deallocations, lhs_.bytes - rhs_.bytes};
+    }
+
+    // "allocations: n/ops_ bytes: n/ops_ deallocations: n/ops_"
+    void print(std::ostream& os_, const uint64_t ops_) const
+    {
+        if (ops_ == 0)
+            return;
+        os_ << " allocations: "   << static_cast<double>(allocations) / ops_
+            << " bytes: "         << static_cast<double>(bytes) / ops_
+            << " deallocations: " << static_cast<double>(deallocations) / ops_;
+    }
+};
+
+#if defined(GBY_COUNT_ALLOCATIONS)
+
+constexpr bool allocationCountingEnabled {true};
+
+// counts of the calling thread since it started, excluding the paused stretches
+AllocationCounts threadAllocationCounts();
+
+// stops/restarts counting the calling thread's allocations, around untimed setup
+void pauseAllocationCounting();
+void resumeAllocationCounting();
+
+#else
+
+constexpr bool allocationCountingEnabled {false};
+
+inline AllocationCounts threadAllocationCounts() { return {}; }
+inline void pauseAllocationCounting() {}
+inline void resumeAllocationCounting() {}
+
+#endif
+
+// the calling thread's allocations since construction
+class AllocationCounter
+{
+public:
+    AllocationCounts read() const { return threadAllocationCounts() - _start; }
+
+private:
+    AllocationCounts _start {threadAllocationCounts()};
+};
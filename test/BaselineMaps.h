@@ -0,0 +1,473 @@
+
+#pragma once
+
+// Thread-safe wrappers around non thread-safe containers, exposing the same
+// insert/find/erase/iterate_map interface as the gby slot maps. These are what
+// the slot maps are measured against in the benchmark and regression harnesses.
+
+#include "slot_map.h"
+#include "backoff.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// test and test-and-set spinlock, satisfies Lockable
+class Spinlock
+{
+public:
+    void lock() noexcept
+    {
+        gby::backoff bo;
+        while (_locked.exchange(true, std::memory_order_acquire))
+        {
+            while (_locked.load(std::memory_order_relaxed))
+                bo.pause();
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        return !_locked.load(std::memory_order_relaxed) &&
+               !_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept { _locked.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> _locked {false};
+};
+
+// spreads sequential ids over the hash table (splitmix64's finalizer)
+constexpr uint64_t mixId(uint64_t id_)
+{
+    id_ = (id_ ^ (id_ >> 30)) * 0xBF58476D1CE4E5B9ull;
+    id_ = (id_ ^ (id_ >> 27)) * 0x94D049BB133111EBull;
+    return id_ ^ (id_ >> 31);
+}
+
+
+// SG14's slot map behind a single lock
+template<
+    typename T,
+    typename Key = std::pair<unsigned, unsigned>,
+    typename Mutex = std::mutex
+>
+class MutexSlotMap
+{
+public:
+    using key_type   = Key;
+    using value_type = T;
+
+    key_type insert(const T& value)
+    {
+        std::lock_guard lg {_mut};
+        return _map.insert(value);
+    }
+
+    key_type insert(T&& value)
+    {
+        std::lock_guard lg {_mut};
+        return _map.insert(std::move(value));
+    }
+
+    std::optional<std::reference_wrapper<T>> find(const key_type& key)
+    {
+        std::lock_guard lg {_mut};
+        auto it = _map.find(key);
+        if (it == _map.end())
+            return {};
+        return *it;
+    }
+
+    bool erase(const key_type& key)
+    {
+        std::lock_guard lg {_mut};
+        return _map.erase(key) > 0;
+    }
+
+    template <class P>
+    void iterate_map(P pred)
+    {
+        std::lock_guard lg {_mut};
+        std::for_each(_map.begin(), _map.end(), pred);
+    }
+
+    void reserve(size_t n)
+    {
+        std::lock_guard lg {_mut};
+        _map.reserve(n);
+    }
+
+    size_t size() const
+    {
+        std::lock_guard lg {_mut};
+        return _map.size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    mutable Mutex                   _mut;
+    stdext::slot_map<T, Key>        _map;
+};
+
+template<typename T, typename Key = std::pair<unsigned, unsigned>>
+using SpinlockSlotMap = MutexSlotMap<T, Key, Spinlock>;
+
+
+// std::unordered_map behind a reader/writer lock, keyed by an ever increasing id
+template<typename T>
+class SharedMutexUnorderedMap
+{
+public:
+    using key_type   = uint64_t;
+    using value_type = T;
+
+    key_type insert(const T& value)
+    {
+        const key_type key = _next_key.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock ul {_mut};
+        _map.emplace(key, value);
+        return key;
+    }
+
+    key_type insert(T&& value)
+    {
+        const key_type key = _next_key.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock ul {_mut};
+        _map.emplace(key, std::move(value));
+        return key;
+    }
+
+    std::optional<std::reference_wrapper<T>> find(const key_type& key)
+    {
+        std::shared_lock sl {_mut};
+        auto it = _map.find(key);
+        if (it == _map.end())
+            return {};
+        return it->second;
+    }
+
+    bool erase(const key_type& key)
+    {
+        std::unique_lock ul {_mut};
+        return _map.erase(key) > 0;
+    }
+
+    template <class P>
+    void iterate_map(P pred)
+    {
+        std::shared_lock sl {_mut};
+        for (auto& [key, value] : _map)
+            pred(value);
+    }
+
+    void reserve(size_t n)
+    {
+        std::unique_lock ul {_mut};
+        _map.reserve(n);
+    }
+
+    size_t size() const
+    {
+        std::shared_lock sl {_mut};
+        return _map.size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    mutable std::shared_mutex           _mut;
+    std::unordered_map<key_type, T>     _map;
+    std::atomic<key_type>               _next_key {};
+};
+
+
+// std::unordered_map split into ShardCount shards, each behind its own
+// reader/writer lock. The shard of a key is picked by its (mixed) id.
+template<typename T, size_t ShardCount = 16>
+class ShardedUnorderedMap
+{
+    static_assert(std::has_single_bit(ShardCount));
+
+public:
+    using key_type   = uint64_t;
+    using value_type = T;
+
+    key_type insert(const T& value)
+    {
+        const key_type key = _next_key.fetch_add(1, std::memory_order_relaxed);
+        auto& shard = shardOf(key);
+        std::unique_lock ul {shard.mut};
+        shard.map.emplace(key, value);
+        return key;
+    }
+
+    key_type insert(T&& value)
+    {
+        const key_type key = _next_key.fetch_add(1, std::memory_order_relaxed);
+        auto& shard = shardOf(key);
+        std::unique_lock ul {shard.mut};
+        shard.map.emplace(key, std::move(value));
+        return key;
+    }
+
+    std::optional<std::reference_wrapper<T>> find(const key_type& key)
+    {
+        auto& shard = shardOf(key);
+        std::shared_lock sl {shard.mut};
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return {};
+        return it->second;
+    }
+
+    bool erase(const key_type& key)
+    {
+        auto& shard = shardOf(key);
+        std::unique_lock ul {shard.mut};
+        return shard.map.erase(key) > 0;
+    }
+
+    // shard by shard, so not a consistent snapshot of the whole map
+    template <class P>
+    void iterate_map(P pred)
+    {
+        for (auto& shard : _shards)
+        {
+            std::shared_lock sl {shard.mut};
+            for (auto& [key, value] : shard.map)
+                pred(value);
+        }
+    }
+
+    void reserve(size_t n)
+    {
+        for (auto& shard : _shards)
+        {
+            std::unique_lock ul {shard.mut};
+            shard.map.reserve(n / ShardCount + 1);
+        }
+    }
+
+    size_t size() const
+    {
+        size_t sz {};
+        for (const auto& shard : _shards)
+        {
+            std::shared_lock sl {shard.mut};
+            sz += shard.map.size();
+        }
+        return sz;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex          mut;
+        std::unordered_map<key_type, T>    map;
+    };
+
+    Shard& shardOf(const key_type& key) { return _shards[mixId(key) & (ShardCount - 1)]; }
+
+    std::array<Shard, ShardCount>   _shards;
+    std::atomic<key_type>           _next_key {};
+};
+
+
+// Open addressing (linear probing) hash map, keyed by a generational id - the
+// same {index, generation} pair the slot maps hand out, taken here from a 64 bit
+// counter whose low half wraps around into the generation. The table is split
+// into ShardCount independent tables, each behind its own reader/writer lock,
+// and an id's whole probe sequence stays within its shard.
+template<typename T, size_t ShardCount = 16>
+class OpenAddressingHashMap
+{
+    static_assert(std::has_single_bit(ShardCount));
+
+    static constexpr uint64_t EMPTY     = 0;
+    static constexpr uint64_t TOMBSTONE = 1;
+    static constexpr uint64_t FIRST_ID  = 2;
+
+    static constexpr size_t   MIN_SHARD_CAPACITY = 16;
+
+public:
+    using key_type   = std::pair<unsigned, unsigned>;
+    using value_type = T;
+
+    OpenAddressingHashMap()
+    {
+        for (auto& shard : _shards)
+            shard.buckets.resize(MIN_SHARD_CAPACITY);
+    }
+
+    key_type insert(const T& value) { return emplace(value); }
+    key_type insert(T&& value)      { return emplace(std::move(value)); }
+
+    std::optional<std::reference_wrapper<T>> find(const key_type& key)
+    {
+        const uint64_t id = toId(key);
+        auto& shard = shardOf(id);
+        std::shared_lock sl {shard.mut};
+        if (auto* bucket = findBucket(shard, id))
+            return bucket->value;
+        return {};
+    }
+
+    bool erase(const key_type& key)
+    {
+        const uint64_t id = toId(key);
+        auto& shard = shardOf(id);
+        std::unique_lock ul {shard.mut};
+        auto* bucket = findBucket(shard, id);
+        if (!bucket)
+            return false;
+
+        bucket->id    = TOMBSTONE;
+        bucket->value = T{};
+        --shard.size;
+        return true;
+    }
+
+    // shard by shard, so not a consistent snapshot of the whole map
+    template <class P>
+    void iterate_map(P pred)
+    {
+        for (auto& shard : _shards)
+        {
+            std::shared_lock sl {shard.mut};
+            for (auto& bucket : shard.buckets)
+                if (bucket.id >= FIRST_ID)
+                    pred(bucket.value);
+        }
+    }
+
+    void reserve(size_t n)
+    {
+        for (auto& shard : _shards)
+        {
+            std::unique_lock ul {shard.mut};
+            rehash(shard, capacityFor(n / ShardCount + 1));
+        }
+    }
+
+    size_t size() const
+    {
+        size_t sz {};
+        for (const auto& shard : _shards)
+        {
+            std::shared_lock sl {shard.mut};
+            sz += shard.size;
+        }
+        return sz;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Bucket
+    {
+        uint64_t id {EMPTY};
+        T        value {};
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex   mut;
+        std::vector<Bucket>         buckets;
+        size_t                      size {};
+        size_t                      used {}; // live elements + tombstones
+    };
+
+    static uint64_t toId(const key_type& key)
+    {
+        return (static_cast<uint64_t>(key.second) << 32) | key.first;
+    }
+
+    // keeps the load factor (tombstones included) under 3/4
+    static size_t capacityFor(const size_t n_)
+    {
+        return std::max(MIN_SHARD_CAPACITY, std::bit_ceil(n_ * 4 / 3 + 1));
+    }
+
+    Shard& shardOf(const uint64_t id_) { return _shards[mixId(id_) & (ShardCount - 1)]; }
+
+    static size_t homeOf(const Shard& shard_, const uint64_t id_)
+    {
+        return (mixId(id_) >> std::countr_zero(ShardCount)) & (shard_.buckets.size() - 1);
+    }
+
+    static Bucket* findBucket(Shard& shard_, const uint64_t id_)
+    {
+        const size_t mask = shard_.buckets.size() - 1;
+        for (size_t idx = homeOf(shard_, id_); ; idx = (idx + 1) & mask)
+        {
+            auto& bucket = shard_.buckets[idx];
+            if (bucket.id == id_)
+                return &bucket;
+            if (bucket.id == EMPTY)
+                return nullptr;
+        }
+    }
+
+    // drops the tombstones on the way
+    static void rehash(Shard& shard_, const size_t capacity_)
+    {
+        if (capacity_ <= shard_.buckets.size() && shard_.used == shard_.size)
+            return;
+
+        auto oldBuckets = std::exchange(shard_.buckets, std::vector<Bucket>(std::max(capacity_, shard_.buckets.size())));
+        for (auto& bucket : oldBuckets)
+            if (bucket.id >= FIRST_ID)
+                place(shard_, bucket.id, std::move(bucket.value));
+        shard_.used = shard_.size;
+    }
+
+    // ids are never reused, so the first free bucket (tombstones included) will do.
+    // Returns whether that bucket was empty, rather than a tombstone.
+    template<typename V>
+    static bool place(Shard& shard_, const uint64_t id_, V&& value_)
+    {
+        const size_t mask = shard_.buckets.size() - 1;
+        size_t idx = homeOf(shard_, id_);
+        while (shard_.buckets[idx].id >= FIRST_ID)
+            idx = (idx + 1) & mask;
+
+        const bool wasEmpty = shard_.buckets[idx].id == EMPTY;
+        shard_.buckets[idx].id    = id_;
+        shard_.buckets[idx].value = std::forward<V>(value_);
+        return wasEmpty;
+    }
+
+    template<typename V>
+    key_type emplace(V&& value_)
+    {
+        const uint64_t id = _next_id.fetch_add(1, std::memory_order_relaxed);
+        auto& shard = shardOf(id);
+        std::unique_lock ul {shard.mut};
+
+        if ((shard.used + 1) * 4 > shard.buckets.size() * 3)
+            rehash(shard, capacityFor(shard.size + 1));
+
+        if (place(shard, id, std::forward<V>(value_)))
+            ++shard.used;
+        ++shard.size;
+        return {static_cast<unsigned>(id), static_cast<unsigned>(id >> 32)};
+    }
+
+    std::array<Shard, ShardCount>   _shards;
+    std::atomic<uint64_t>           _next_id {FIRST_ID};
+};
@@ -0,0 +1,64 @@
+
+#include "../RegressionTestHelpers.h"
+#include "../BaselineMaps.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+constexpr size_t iterationCount {50000};
+
+constexpr size_t WriterCount {2};
+constexpr size_t MCMP_writesPerWriter {iterationCount/WriterCount};
+
+
+template<typename Map>
+void runBaselineRegression()
+{
+    Map map;
+    map.reserve(iterationCount);
+    test_SPMC<iterationCount, 3>(map, []() { return rand();}, false);
+
+    Map map2;
+    map2.reserve(iterationCount);
+    test_SPMC<iterationCount, 3>(map2, []() { return rand();}, true);
+
+    Map map3;
+    map3.reserve(iterationCount);
+    test_MPMC<WriterCount, MCMP_writesPerWriter, 2, 3>(map3, [] { return rand();});
+}
+
+TEST(BaselineMaps, SG14SlotMapMutex)
+{
+    runBaselineRegression<MutexSlotMap<int>>();
+}
+
+TEST(BaselineMaps, SG14SlotMapSpinlock)
+{
+    runBaselineRegression<SpinlockSlotMap<int>>();
+}
+
+TEST(BaselineMaps, UnorderedMapSharedMutex)
+{
+    runBaselineRegression<SharedMutexUnorderedMap<int>>();
+}
+
+TEST(BaselineMaps, ShardedUnorderedMap)
+{
+    runBaselineRegression<ShardedUnorderedMap<int>>();
+}
+
+TEST(BaselineMaps, OpenAddressingHashMap)
+{
+    runBaselineRegression<OpenAddressingHashMap<int>>();
+}
+
+TEST(BaselineMaps, OpenAddressingHashMapStringElement)
+{
+    constexpr size_t strCount {25};
+    auto strInput = genStrInput<strCount>();
+
+    OpenAddressingHashMap<std::string> map;
+    map.reserve(iterationCount);
+    test_MPMC<WriterCount, MCMP_writesPerWriter, 1, 5>(map, [&strInput] { return strInput[rand()%strCount];});
+}
@@ -0,0 +1,83 @@
+
+#include "../UnitTestHelpers.h"
+#include "../BaselineMaps.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+
+TEST(BaselineMapsUnit, SpinlockSlotMap)
+{
+    SpinlockSlotMap<int> intMap;
+    std::array<int, 3> intVals {48, 0, -9823};
+    addQueryAndRemoveElement_Baseline(intMap, intVals);
+
+    SpinlockSlotMap<std::string> stringMap;
+    std::array<std::string, 3> stringVals {"this is a string", {}, "ABC."};
+    addQueryAndRemoveElement_Baseline(stringMap, stringVals);
+}
+
+TEST(BaselineMapsUnit, ShardedUnorderedMap)
+{
+    ShardedUnorderedMap<int> intMap;
+    std::array<int, 3> intVals {48, 0, -9823};
+    addQueryAndRemoveElement_Baseline(intMap, intVals);
+
+    ShardedUnorderedMap<TestObj> testObjMap;
+    std::array<TestObj, 3> testObjVals { TestObj{156, 'b', "this is a string"},
+                                         TestObj{},
+                                         TestObj{-124, 'Q', "anotherSTRING"} };
+    addQueryAndRemoveElement_Baseline(testObjMap, testObjVals);
+}
+
+TEST(BaselineMapsUnit, OpenAddressingHashMap)
+{
+    OpenAddressingHashMap<int> intMap;
+    std::array<int, 3> intVals {48, 0, -9823};
+    addQueryAndRemoveElement_Baseline(intMap, intVals);
+
+    OpenAddressingHashMap<std::string> stringMap;
+    std::array<std::string, 3> stringVals {"this is a string", {}, "ABC."};
+    addQueryAndRemoveElement_Baseline(stringMap, stringVals);
+}
+
+// grows the shards and fills them with tombstones, which the inserts reuse
+TEST(BaselineMapsUnit, OpenAddressingHashMapGrowAndReuse)
+{
+    constexpr int elementCount {10000};
+
+    OpenAddressingHashMap<int> map;
+    std::vector<OpenAddressingHashMap<int>::key_type> keys;
+    for (int i = 0; i < elementCount; ++i)
+        keys.push_back(map.insert(i));
+    EXPECT_EQ(elementCount, map.size());
+
+    for (int i = 0; i < elementCount; i += 2)
+        EXPECT_TRUE(map.erase(keys[i]));
+    EXPECT_EQ(elementCount/2, map.size());
+
+    for (int i = 0; i < elementCount; ++i)
+        keys.push_back(map.insert(elementCount + i));
+
+    for (int i = 0; i < elementCount; ++i)
+    {
+        if (i % 2 == 0)
+            EXPECT_FALSE(map.find(keys[i]).has_value());
+        else
+            EXPECT_EQ(i, (*map.find(keys[i])).get());
+    }
+    for (int i = 0; i < elementCount; ++i)
+        EXPECT_EQ(elementCount + i, (*map.find(keys[elementCount + i])).get());
+
+    int64_t expectedSum {};
+    for (int i = 1; i < elementCount; i += 2)
+        expectedSum += i;
+    for (int i = 0; i < elementCount; ++i)
+        expectedSum += elementCount + i;
+
+    int64_t sum {};
+    map.iterate_map([&sum](int val) { sum += val; });
+    EXPECT_EQ(expectedSum, sum);
+}
@@ -0,0 +1,249 @@
+
+#pragma once
+
+// CPU topology discovery (from /sys/devices/system/cpu) and thread pinning, so
+// that the concurrent tests run with a known, repeatable thread placement
+// rather than whatever the scheduler picks.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct LogicalCpu
+{
+    int cpu    {};
+    int core   {};  // physical core id, unique within its socket
+    int socket {};
+    int smt    {};  // index of this hardware thread among its core's siblings
+};
+
+enum class PinningPolicy
+{
+    None,           // left to the scheduler
+    Compact,        // fill a core's hardware threads, then the next core of the same socket
+    Scatter,        // one thread per physical core (socket by socket) before using SMT siblings
+    SameSocket,     // as scatter, but only on the first socket
+    CrossSocket     // alternate between the sockets, one thread per physical core first
+};
+
+constexpr const char* pinningPolicyName(const PinningPolicy policy_)
+{
+    switch (policy_)
+    {
+        case PinningPolicy::None:        return "none";
+        case PinningPolicy::Compact:     return "compact";
+        case PinningPolicy::Scatter:     return "scatter";
+        case PinningPolicy::SameSocket:  return "same-socket";
+        case PinningPolicy::CrossSocket: return "cross-socket";
+    }
+    return "";
+}
+
+inline PinningPolicy parsePinningPolicy(const std::string& name_)
+{
+    for (auto policy : {PinningPolicy::None, PinningPolicy::Compact, PinningPolicy::Scatter,
+                        PinningPolicy::SameSocket, PinningPolicy::CrossSocket})
+        if (name_ == pinningPolicyName(policy))
+            return policy;
+    throw std::invalid_argument("unknown pinning policy: " + name_);
+}
+
+// policy of the regression tests, from the GBY_SLOTMAP_PINNING environment variable
+inline PinningPolicy pinningPolicyFromEnv()
+{
+    const char* name = std::getenv("GBY_SLOTMAP_PINNING");
+    return name ? parsePinningPolicy(name) : PinningPolicy::None;
+}
+
+
+class CpuTopology
+{
+public:
+    // the cpus this process may run on. Falls back to hardware_concurrency
+    // cpus, each its own core on a single socket, when sysfs isn't readable.
+    static const CpuTopology& get()
+    {
+        static const CpuTopology topology {};
+        return topology;
+    }
+
+    const std::vector<LogicalCpu>& cpus() const { return _cpus; }
+
+    size_t socketCount() const
+    {
+        std::vector<int> sockets;
+        for (const auto& cpu : _cpus)
+            if (std::find(sockets.begin(), sockets.end(), cpu.socket) == sockets.end())
+                sockets.push_back(cpu.socket);
+        return sockets.size();
+    }
+
+    // the cpu of each of threadCount_ threads, -1 for unpinned ones. When there
+    // are more threads than cpus allowed by the policy, they wrap around.
+    std::vector<int> placement(const PinningPolicy policy_, const size_t threadCount_) const
+    {
+        if (policy_ == PinningPolicy::None || _cpus.empty())
+            return std::vector<int>(threadCount_, -1);
+
+        auto order = _cpus;
+        const int firstSocket = std::min_element(order.begin(), order.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.socket < rhs.socket; })->socket;
+
+        switch (policy_)
+        {
+            case PinningPolicy::Compact:
+                sortBy(order, [](const LogicalCpu& c) { return std::tuple{c.socket, c.core, c.smt}; });
+                break;
+            case PinningPolicy::SameSocket:
+                std::erase_if(order, [=](const LogicalCpu& c) { return c.socket != firstSocket; });
+                [[fallthrough]];
+            case PinningPolicy::Scatter:
+                sortBy(order, [](const LogicalCpu& c) { return std::tuple{c.smt, c.socket, c.core}; });
+                break;
+            case PinningPolicy::CrossSocket:
+            {
+                // rank of every core within its socket, so that the sockets take turns
+                std::map<std::pair<int, int>, int> coreRank;
+                std::map<int, int> coresPerSocket;
+                sortBy(order, [](const LogicalCpu& c) { return std::tuple{c.socket, c.core, c.smt}; });
+                for (const auto& c : order)
+                    if (!coreRank.contains({c.socket, c.core}))
+                        coreRank[{c.socket, c.core}] = coresPerSocket[c.socket]++;
+                sortBy(order, [&](const LogicalCpu& c)
+                    { return std::tuple{c.smt, coreRank.at({c.socket, c.core}), c.socket}; });
+                break;
+            }
+            case PinningPolicy::None:
+                break;
+        }
+
+        std::vector<int> cpus (threadCount_);
+        for (size_t i = 0; i < threadCount_; ++i)
+            cpus[i] = order[i % order.size()].cpu;
+        return cpus;
+    }
+
+private:
+    CpuTopology()
+    {
+        for (int cpu : parseCpuList(readLine("/sys/devices/system/cpu/online")))
+        {
+            if (!allowed(cpu))
+                continue;
+
+            const std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            LogicalCpu logicalCpu {cpu, cpu, 0, 0};
+            try
+            {
+                logicalCpu.core   = std::stoi(readLine(topology + "core_id"));
+                logicalCpu.socket = std::stoi(readLine(topology + "physical_package_id"));
+            }
+            catch (const std::exception&) {}
+            _cpus.push_back(logicalCpu);
+        }
+
+        if (_cpus.empty())
+        {
+            for (int cpu = 0; cpu < static_cast<int>(std::thread::hardware_concurrency()); ++cpu)
+                _cpus.push_back({cpu, cpu, 0, 0});
+            return;
+        }
+
+        // the siblings of a core are numbered in the order of their cpu ids
+        std::map<std::pair<int, int>, int> siblings;
+        for (auto& cpu : _cpus)
+            cpu.smt = siblings[{cpu.socket, cpu.core}]++;
+    }
+
+    template<typename Key>
+    static void sortBy(std::vector<LogicalCpu>& cpus_, Key key_)
+    {
+        std::stable_sort(cpus_.begin(), cpus_.end(),
+            [&](const LogicalCpu& lhs, const LogicalCpu& rhs) { return key_(lhs) < key_(rhs); });
+    }
+
+    static std::string readLine(const std::string& path_)
+    {
+        std::ifstream file {path_};
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    // "0-3,8,10-11" to {0, 1, 2, 3, 8, 10, 11}
+    static std::vector<int> parseCpuList(const std::string& list_)
+    {
+        std::vector<int> cpus;
+        std::istringstream ss {list_};
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            try
+            {
+                const auto dash = range.find('-');
+                const int  first = std::stoi(range.substr(0, dash));
+                const int  last  = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+            catch (const std::exception&) {}
+        }
+        return cpus;
+    }
+
+    // whether the process' affinity mask (e.g. taskset, cgroups) allows cpu_
+    static bool allowed([[maybe_unused]] const int cpu_)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            return CPU_ISSET(cpu_, &set);
+#endif
+        return true;
+    }
+
+    std::vector<LogicalCpu> _cpus;
+};
+
+// pins the calling thread to cpu_, a no-op for -1. Returns whether it's pinned.
+inline bool pinCurrentThread(const int cpu_)
+{
+    if (cpu_ < 0)
+        return false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// "name: cpu,cpu,..." or "name: unpinned"
+inline void printPlacement(std::ostream& os_, const std::string& name_,
+                           std::vector<int>::const_iterator first_, std::vector<int>::const_iterator last_)
+{
+    os_ << name_ << ":";
+    if (first_ == last_ || *first_ < 0)
+    {
+        os_ << (first_ == last_ ? " none" : " unpinned");
+        return;
+    }
+    for (auto it = first_; it != last_; ++it)
+        os_ << (it == first_ ? " cpu " : ",") << *it;
+}
@@ -0,0 +1,11 @@
+#include "../RegressionTestHelpers.h"
+#include "dynamic_slot_map.h"
+
+#include <gtest/gtest.h>
+
+
+TEST(DynamicSlotMap, RealTimeNoAllocations)
+{
+    gby::dynamic_slot_map<int> map {gby::real_time, 1 << 12};
+    test_realTimeNoAllocations<4, 200000>(map);
+}
@@ -6,6 +6,10 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <deque>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 
 TEST(DynamicallyResizable, IntElement)
@@ -86,3 +90,63 @@ TEST(DynamicallyResizable, IterateOverTestObj)
     }
 
 }
+
+TEST(DynamicallyResizable, Stats)
+{
+    gby::dynamic_slot_map<int> map {10};
+    checkSingleThreadedStats<100>(map);
+
+    if constexpr (gby::slot_map_counters::enabled)
+        EXPECT_LT(0, map.stats().growth_events);
+    else
+        EXPECT_EQ(0, map.stats().growth_events);
+}
+
+TEST(DynamicallyResizable, RealTimeDoesntGrow)
+{
+    gby::dynamic_slot_map<int> map {gby::real_time, 8};
+    EXPECT_TRUE(map.is_real_time());
+
+    tryInsertOnFullMap<8>(map, 42);
+}
+
+TEST(DynamicallyResizable, NothrowLookupAndInsert)
+{
+    gby::dynamic_slot_map<int> map {gby::real_time, 8};
+
+    nothrowLookupAndInsert<8>(map, 42);
+}
+
+// the inserters waiting on a growth that fails must still wake up
+TEST(DynamicallyResizable, GrowsUpToMaxCapacity)
+{
+    using Map = gby::dynamic_slot_map<int>;
+    Map map {1};
+
+    std::atomic<size_t> inserted {};
+    std::atomic<size_t> atMaxCapacity {};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&]() {
+            try
+            {
+                while (true)
+                {
+                    map.insert(i);
+                    ++inserted;
+                }
+            }
+            catch (const std::length_error&)
+            {
+                ++atMaxCapacity;
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(4, atMaxCapacity.load());
+    EXPECT_EQ(Map::max_capacity(), map.capacity());
+    EXPECT_EQ(Map::max_capacity(), inserted.load());
+    EXPECT_EQ(Map::max_capacity(), map.size());
+    EXPECT_THROW(map.reserve(Map::max_capacity() + 1), std::length_error);
+}
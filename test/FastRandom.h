@@ -0,0 +1,91 @@
+
+#pragma once
+
+// Cheap pseudo random numbers for the test harness, so that generating the
+// workload costs next to nothing next to the map operations it measures:
+// rand() takes a lock in glibc, std::mt19937 drags around 2.5KB of state.
+//  - SplitMix64: one 64 bit word of state, used to seed the others
+//  - Xoshiro256: xoshiro256** (Blackman & Vigna), the per-thread generator
+// Both are UniformRandomBitGenerators, so they work with the std distributions.
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+class SplitMix64
+{
+public:
+    using result_type = uint64_t;
+
+    explicit SplitMix64(const uint64_t seed_)
+            : _state {seed_}
+    {}
+
+    uint64_t operator()()
+    {
+        uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+
+private:
+    uint64_t _state;
+};
+
+class Xoshiro256
+{
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(const uint64_t seed_)
+    {
+        SplitMix64 seeder {seed_};
+        for (auto& word : _state)
+            word = seeder();
+    }
+
+    uint64_t operator()()
+    {
+        const uint64_t result = rotl(_state[1] * 5, 7) * 9;
+        const uint64_t t      = _state[1] << 17;
+
+        _state[2] ^= _state[0];
+        _state[3] ^= _state[1];
+        _state[1] ^= _state[2];
+        _state[0] ^= _state[3];
+        _state[2] ^= t;
+        _state[3]  = rotl(_state[3], 45);
+        return result;
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+
+private:
+    static constexpr uint64_t rotl(const uint64_t x_, const int k_)
+    {
+        return (x_ << k_) | (x_ >> (64 - k_));
+    }
+
+    uint64_t _state[4];
+};
+
+// maps a 64 bit random draw_ onto [0, bound_) with a multiply and a shift
+// (Lemire) instead of a modulo, the bias is negligible for the bounds used here
+inline uint64_t pickIndex(const uint64_t draw_, const uint64_t bound_)
+{
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(draw_) * bound_) >> 64);
+}
+
+// the calling thread's generator, for where the harness used to call rand().
+// Every thread gets its own seed, in the order the threads first ask for it.
+inline Xoshiro256& threadRandom()
+{
+    static std::atomic<uint64_t> nextSeed {1};
+    thread_local Xoshiro256 randomEngine {nextSeed.fetch_add(1, std::memory_order_relaxed)};
+    return randomEngine;
+}
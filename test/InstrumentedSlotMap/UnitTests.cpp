@@ -0,0 +1,132 @@
+
+#include "../UnitTestHelpers.h"
+
+#include "instrumented_slot_map.h"
+#include "dynamic_slot_map.h"
+#include "locked_slot_map.h"
+#include "optimized_locked_slot_map.h"
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+template<class Map>
+using instrumented = gby::instrumented_slot_map<Map>;
+
+template<class Map>
+void checkCounts(const instrumented<Map>& map, const size_t inserts, const size_t erases, const size_t finds, const size_t iterates)
+{
+    using op = typename instrumented<Map>::operation;
+    EXPECT_EQ(inserts,  map.latencies(op::insert).count());
+    EXPECT_EQ(erases,   map.latencies(op::erase).count());
+    EXPECT_EQ(finds,    map.latencies(op::find).count());
+    EXPECT_EQ(iterates, map.latencies(op::iterate).count());
+}
+
+TEST(InstrumentedSlotMap, DynamicSlotMap)
+{
+    instrumented<gby::dynamic_slot_map<std::string>> stringMap {1, 2};
+    std::array<std::string, 3> vals {"this is a string", {}, "ABC."};
+
+    addQueryAndRemoveElement(stringMap, vals);
+    checkCounts(stringMap, 3, 3, 12, 0);
+}
+
+TEST(InstrumentedSlotMap, OptimizedLockedSlotMap)
+{
+    instrumented<gby::optimized_locked_slot_map<TestObj, 3, std::pair<int32_t, uint64_t>>> testObjMap;
+    std::array<TestObj, 3> vals { TestObj{156, 'b', "this is a string"},
+                                  TestObj{},
+                                  TestObj{-124, 'Q', "anotherSTRING"} };
+
+    addQueryAndRemoveElement(testObjMap, vals);
+    checkCounts(testObjMap, 3, 3, 12, 0);
+}
+
+TEST(InstrumentedSlotMap, LockedSlotMap)
+{
+    instrumented<gby::locked_slot_map<int>> intMap;
+    std::array<int, 3> vals {48, 0, -9823};
+
+    addQueryAndRemoveElement_Locked(intMap, vals);
+    checkCounts(intMap, 3, 3, 12, 0);
+}
+
+TEST(InstrumentedSlotMap, MergesThreads)
+{
+    constexpr size_t THREADS = 4;
+    constexpr size_t WRITES  = 1000;
+
+    instrumented<gby::dynamic_slot_map<int>> map {10};
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t)
+    {
+        threads.emplace_back([&map]() {
+            for (size_t i = 0; i < WRITES; ++i)
+            {
+                const auto key = map.insert(static_cast<int>(i));
+                EXPECT_EQ(static_cast<int>(i), map[key]);
+                if (i % 2 == 0)
+                    map.erase(key);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    size_t sum {};
+    map.iterate_map([&sum](const int val) { sum += val; });
+
+    EXPECT_EQ(THREADS * WRITES / 2, map.size());
+    checkCounts(map, THREADS * WRITES, THREADS * WRITES / 2, THREADS * WRITES, 1);
+}
+
+TEST(InstrumentedSlotMap, Export)
+{
+    instrumented<gby::dynamic_slot_map<int>> map {10};
+    for (int i = 0; i < 100; ++i)
+        map.find(map.insert(i));
+
+    std::ostringstream json;
+    map.write_json(json, "ids");
+    EXPECT_EQ(0, json.str().find("{\"map\": \"ids\", \"operations\": {\"insert\": {\"count\": 100, "));
+    EXPECT_NE(std::string::npos, json.str().find("\"erase\": {\"count\": 0, "));
+
+    std::ostringstream prometheus;
+    map.write_prometheus(prometheus, "ids");
+    const std::string metric = "gby_slot_map_operation_latency_seconds";
+    EXPECT_EQ(0, prometheus.str().find("# HELP " + metric));
+    EXPECT_NE(std::string::npos, prometheus.str().find(metric + "_bucket{map=\"ids\",operation=\"find\",le=\"+Inf\"} 100\n"));
+    EXPECT_NE(std::string::npos, prometheus.str().find(metric + "_count{map=\"ids\",operation=\"insert\"} 100\n"));
+
+    // every operation's buckets are cumulative
+    std::istringstream lines {prometheus.str()};
+    std::string line;
+    uint64_t prev {};
+    while (std::getline(lines, line))
+    {
+        if (line.find(metric + "_bucket") != 0)
+            continue;
+        const uint64_t count = std::stoull(line.substr(line.rfind(' ') + 1));
+        if (line.find("le=\"1.6e-08\"") == std::string::npos)
+        {
+            EXPECT_LE(prev, count) << line;
+        }
+        prev = count;
+    }
+
+    const auto path = std::filesystem::temp_directory_path() / "gby_instrumented_slot_map.prom";
+    ASSERT_TRUE(map.write_prometheus_file(path, "ids"));
+    std::ifstream file {path};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(prometheus.str(), contents.str());
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+    std::filesystem::remove(path);
+}
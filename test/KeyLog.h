@@ -0,0 +1,48 @@
+
+#pragma once
+
+// Append-only log of the keys a writer inserted, which readers pick random
+// keys out of while the writer keeps appending. Preallocated to its capacity,
+// so appending never moves the published keys: the single writer stores the
+// key and then publishes it with a release store of the count, a reader may
+// read any key below an acquire load of that count.
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+template<typename Key>
+class KeyLog
+{
+public:
+    explicit KeyLog(const size_t capacity_)
+            : _capacity {capacity_}
+            , _keys {std::make_unique<Key[]>(capacity_)}
+    {}
+
+    KeyLog(const KeyLog&) = delete;
+    KeyLog& operator=(const KeyLog&) = delete;
+
+    // only ever called by the log's one writer
+    void append(const Key& key_)
+    {
+        const size_t count = _published.load(std::memory_order_relaxed);
+        assert(count < _capacity);
+        _keys[count] = key_;
+        _published.store(count + 1, std::memory_order_release);
+    }
+
+    // the amount of keys that are safe to read
+    size_t published() const { return _published.load(std::memory_order_acquire); }
+
+    const Key& operator[](const size_t idx_) const { return _keys[idx_]; }
+
+    size_t capacity() const { return _capacity; }
+
+private:
+    const size_t           _capacity;
+    std::unique_ptr<Key[]> _keys;
+    // on a line of its own, the writer bumping it doesn't evict the readers' copy of _keys
+    alignas(64) std::atomic<size_t> _published {};
+};
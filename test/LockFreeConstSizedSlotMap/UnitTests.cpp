@@ -4,8 +4,11 @@
 #include "lock_free_const_sized_slot_map.h"
 
 #include <gtest/gtest.h>
+#include <atomic>
+#include <future>
 #include <string>
 #include <deque>
+#include <thread>
 
 
 TEST(LockFreeConstSizedUnit, IntElement)
@@ -62,3 +65,77 @@ TEST(LockFreeConstSizedUnit, IterateOverTestObj)
     }
 
 }
+
+TEST(LockFreeConstSizedUnit, InsertWaitOnFullMap)
+{
+    gby::lock_free_const_sized_slot_map<std::string, 8> stringMap;
+
+    insertWaitOnFullMap<8>(stringMap, std::string{"waiting for a free slot"});
+}
+
+TEST(LockFreeConstSizedUnit, TryInsertOnFullMap)
+{
+    gby::lock_free_const_sized_slot_map<int, 8> intMap;
+
+    tryInsertOnFullMap<8>(intMap, 42);
+}
+
+// assigning one with a gate blocks until the gate opens, which holds up the
+// insert mid-way: its element's place is claimed but not published yet
+struct GatedValue
+{
+    std::atomic<bool>* gate {};
+    int value {};
+
+    GatedValue& operator=(const GatedValue& other_)
+    {
+        while (other_.gate && !other_.gate->load())
+            std::this_thread::yield();
+        gate  = nullptr;
+        value = other_.value;
+        return *this;
+    }
+};
+
+TEST(LockFreeConstSizedUnit, TryInsertGivesUpBehindStalledInsert)
+{
+    gby::lock_free_const_sized_slot_map<GatedValue, 4> map;
+
+    std::atomic<bool> gate {false};
+    auto stalled = std::async(std::launch::async, [&map, &gate] { return map.insert(GatedValue{&gate, 1}); });
+    while (map.size() == 0)
+        std::this_thread::yield();
+
+    EXPECT_FALSE(map.try_insert(GatedValue{nullptr, 2}, 8).has_value());
+    EXPECT_EQ(gby::slot_map_errc::full, map.insert_nothrow(GatedValue{nullptr, 3}, 8).error());
+
+    gate = true;
+    std::vector<decltype(map)::key_type> keys {stalled.get()};
+
+    // the slots of the inserts that gave up went back to the free list
+    for (int i = 0; i < 3; ++i)
+    {
+        auto key = map.try_insert(GatedValue{nullptr, 4+i});
+        ASSERT_TRUE(key.has_value());
+        keys.push_back(*key);
+    }
+    EXPECT_FALSE(map.try_insert(GatedValue{}).has_value());
+    EXPECT_EQ(4, map.size());
+
+    EXPECT_EQ(1, map.find(keys[0])->get().value);
+    for (int i = 0; i < 3; ++i)
+        EXPECT_EQ(4+i, map.find(keys[i+1])->get().value);
+}
+
+TEST(LockFreeConstSizedUnit, NothrowLookupAndInsert)
+{
+    gby::lock_free_const_sized_slot_map<int, 8> intMap;
+
+    nothrowLookupAndInsert<8>(intMap, 42);
+}
+
+TEST(LockFreeConstSizedUnit, Stats)
+{
+    gby::lock_free_const_sized_slot_map<int, 100> map;
+    checkSingleThreadedStats<100>(map);
+}
@@ -6,6 +6,8 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <deque>
+#include <utility>
+#include <vector>
 
 
 TEST(LockedSlotMapUnit, IntElement)
@@ -33,3 +35,29 @@ TEST(LockedSlotMapUnit, TestObjElement)
 
     addQueryAndRemoveElement_Locked(testObjMap, vals);
 }
+
+TEST(LockedSlotMapUnit, NothrowLookupAndInsert)
+{
+    // a key index of 8 bits runs out at 255 elements
+    gby::locked_slot_map<int, std::pair<uint8_t, unsigned>> map;
+    static_assert(noexcept(map.lookup(std::declval<std::pair<uint8_t, unsigned>>())));
+
+    std::vector<std::pair<uint8_t, unsigned>> keys{};
+    for (size_t i = 0; i < 255; ++i)
+    {
+        auto key = map.insert_nothrow(42);
+        ASSERT_TRUE(key.has_value());
+        keys.push_back(*key);
+    }
+    EXPECT_EQ(gby::slot_map_errc::full, map.insert_nothrow(42).error());
+
+    auto found = map.lookup(keys[0]);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(42, found->get());
+    EXPECT_EQ(gby::slot_map_errc::out_of_range, map.lookup({255, 0}).error());
+    EXPECT_EQ(gby::slot_map_errc::out_of_range, std::as_const(map).lookup({255, 0}).error());
+
+    map.erase(keys[0]);
+    EXPECT_EQ(gby::slot_map_errc::stale_key, map.lookup(keys[0]).error());
+    EXPECT_TRUE(map.insert_nothrow(42).has_value());
+}
@@ -0,0 +1,11 @@
+#include "../RegressionTestHelpers.h"
+#include "optimized_locked_slot_map.h"
+
+#include <gtest/gtest.h>
+
+
+TEST(OptimizedLockedSlotMap, RealTimeNoAllocations)
+{
+    gby::optimized_locked_slot_map<int, 1 << 12> map;
+    test_realTimeNoAllocations<4, 200000>(map);
+}
@@ -94,4 +94,4 @@ TEST(OptimizedLockedSlotMap, MCMPIntElement)
 
      gby::optimized_locked_slot_map<TestObj, 1000000, std::pair<int32_t, uint64_t>> map;
      test_MPMC<WriterCount, MCMP_writesPerWriter, 0, 3>(map, [&testObjInput] { return testObjInput[rand()%testObjCount];});
- }
\ No newline at end of file
+ }
@@ -62,3 +62,30 @@ TEST(OptimizedConstSizedUnit, IterateOverTestObj)
     }
 
 }
+
+TEST(OptimizedConstSizedUnit, InsertWaitOnFullMap)
+{
+    gby::optimized_locked_slot_map<std::string, 8> stringMap;
+
+    insertWaitOnFullMap<8>(stringMap, std::string{"waiting for a free slot"});
+}
+
+TEST(OptimizedConstSizedUnit, TryInsertOnFullMap)
+{
+    gby::optimized_locked_slot_map<int, 8> intMap;
+
+    tryInsertOnFullMap<8>(intMap, 42);
+}
+
+TEST(OptimizedConstSizedUnit, NothrowLookupAndInsert)
+{
+    gby::optimized_locked_slot_map<int, 8> intMap;
+
+    nothrowLookupAndInsert<8>(intMap, 42);
+}
+
+TEST(OptimizedConstSizedUnit, Stats)
+{
+    gby::optimized_locked_slot_map<int, 100> map;
+    checkSingleThreadedStats<100>(map);
+}
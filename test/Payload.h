@@ -0,0 +1,43 @@
+
+#pragma once
+
+// Value types the benchmarks and the workload driver are run with.
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// fixed width value, the first 8 bytes hold the value it was generated from
+template<size_t Width>
+struct Payload
+{
+    static_assert(Width >= sizeof(int64_t));
+
+    Payload() = default;
+    explicit Payload(const int64_t seed_) { std::memcpy(bytes.data(), &seed_, sizeof(seed_)); }
+
+    std::array<char, Width> bytes {};
+};
+
+template<typename T>
+T makeValue(const size_t i_)
+{
+    if constexpr (std::is_same_v<T, std::string>)
+        return "identifier_" + std::to_string(i_);
+    else
+        return T(static_cast<int64_t>(i_));
+}
+
+// cheap read of a value, so that reading an element actually touches it
+template<typename T>
+int64_t sampleValue(const T& val_)
+{
+    if constexpr (std::is_same_v<T, std::string>)
+        return static_cast<int64_t>(val_.size());
+    else if constexpr (std::is_arithmetic_v<T>)
+        return val_;
+    else
+        return val_.bytes[0];
+}
@@ -0,0 +1,212 @@
+
+#pragma once
+
+// Hardware performance counters of the calling thread, via perf_event_open.
+// Every event is opened on its own, so whatever the kernel/PMU supports gets
+// counted; in containers, VMs or with a restrictive perf_event_paranoid, events
+// (or all of them) are simply unavailable and not reported.
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <optional>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class PerfEvent
+{
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    DTLBMisses,
+    BranchMisses
+};
+
+constexpr std::array<PerfEvent, 6> allPerfEvents {
+    PerfEvent::Cycles, PerfEvent::Instructions, PerfEvent::L1DMisses,
+    PerfEvent::LLCMisses, PerfEvent::DTLBMisses, PerfEvent::BranchMisses
+};
+
+constexpr const char* perfEventName(const PerfEvent event_)
+{
+    switch (event_)
+    {
+        case PerfEvent::Cycles:       return "cycles";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::L1DMisses:    return "l1d_misses";
+        case PerfEvent::LLCMisses:    return "llc_misses";
+        case PerfEvent::DTLBMisses:   return "dtlb_misses";
+        case PerfEvent::BranchMisses: return "branch_misses";
+    }
+    return "";
+}
+
+// counts per event, empty for the events that couldn't be counted
+struct PerfCounterValues
+{
+    std::array<std::optional<uint64_t>, allPerfEvents.size()> counts {};
+
+    bool any() const
+    {
+        for (const auto& count : counts)
+            if (count)
+                return true;
+        return false;
+    }
+
+    PerfCounterValues& operator+=(const PerfCounterValues& other_)
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+            if (other_.counts[i])
+                counts[i] = counts[i].value_or(0) + *other_.counts[i];
+        return *this;
+    }
+
+    // "name: count/ops_" for every available event
+    void print(std::ostream& os_, const uint64_t ops_) const
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+            if (counts[i] && ops_ > 0)
+                os_ << " " << perfEventName(allPerfEvents[i]) << ": "
+                    << static_cast<double>(*counts[i]) / ops_;
+    }
+};
+
+
+class PerfCounters
+{
+public:
+    PerfCounters()
+    {
+#if defined(__linux__)
+        for (size_t i = 0; i < allPerfEvents.size(); ++i)
+            _fds[i] = open(allPerfEvents[i]);
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (int fd : _fds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const
+    {
+        for (int fd : _fds)
+            if (fd >= 0)
+                return true;
+        return false;
+    }
+
+    // counting accumulates over consecutive start/stop pairs
+    void start()
+    {
+#if defined(__linux__)
+        for (int fd : _fds)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    void stop()
+    {
+#if defined(__linux__)
+        for (int fd : _fds)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+
+    void reset()
+    {
+#if defined(__linux__)
+        for (int fd : _fds)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+#endif
+    }
+
+    PerfCounterValues read() const
+    {
+        PerfCounterValues values {};
+#if defined(__linux__)
+        for (size_t i = 0; i < _fds.size(); ++i)
+        {
+            if (_fds[i] < 0)
+                continue;
+
+            // when there are more events than hardware counters the kernel
+            // multiplexes them, so the count is scaled up by enabled/running time
+            struct { uint64_t value, timeEnabled, timeRunning; } data {};
+            if (::read(_fds[i], &data, sizeof(data)) != sizeof(data) || data.timeRunning == 0)
+                continue;
+
+            values.counts[i] = static_cast<uint64_t>(
+                    static_cast<double>(data.value) * data.timeEnabled / data.timeRunning);
+        }
+#endif
+        return values;
+    }
+
+private:
+#if defined(__linux__)
+    static int open(const PerfEvent event_)
+    {
+        perf_event_attr attr {};
+        attr.size           = sizeof(attr);
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        constexpr auto cacheReadMiss = [](const uint64_t cache_)
+            { return cache_ | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16); };
+
+        switch (event_)
+        {
+            case PerfEvent::Cycles:
+                attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES;     break;
+            case PerfEvent::Instructions:
+                attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS;   break;
+            case PerfEvent::BranchMisses:
+                attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES;  break;
+            case PerfEvent::L1DMisses:
+                attr.type = PERF_TYPE_HW_CACHE; attr.config = cacheReadMiss(PERF_COUNT_HW_CACHE_L1D);  break;
+            case PerfEvent::LLCMisses:
+                attr.type = PERF_TYPE_HW_CACHE; attr.config = cacheReadMiss(PERF_COUNT_HW_CACHE_LL);   break;
+            case PerfEvent::DTLBMisses:
+                attr.type = PERF_TYPE_HW_CACHE; attr.config = cacheReadMiss(PERF_COUNT_HW_CACHE_DTLB); break;
+        }
+
+        // this thread only, on whichever cpu it runs
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0)
+        {
+            const int err = errno;
+            static std::array<std::once_flag, allPerfEvents.size()> warnOnce;
+            std::call_once(warnOnce[static_cast<size_t>(event_)], [&] {
+                std::cerr << "perf event " << perfEventName(event_) << " unavailable ("
+                          << std::strerror(err) << "), reporting without it" << std::endl;
+            });
+        }
+        return fd;
+    }
+#endif
+
+    std::array<int, allPerfEvents.size()> _fds {-1, -1, -1, -1, -1, -1};
+};
@@ -2,7 +2,32 @@
 
 #include "RegressionTestHelpers.h"
 
+#include <cstdlib>
+
 char alphaNum[63] = "0123456789"
                   "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
                   "abcdefghijklmnopqrstuvwxyz";
 
+
+void startTrace()
+{
+#if defined(GBY_SLOT_MAP_TRACE)
+    gby::trace_log::instance().clear();
+#endif
+}
+
+std::string traceLine()
+{
+#if defined(GBY_SLOT_MAP_TRACE)
+    const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    const char* dir  = std::getenv("GBY_SLOTMAP_TRACE_DIR");
+
+    std::string path = (dir ? std::string{dir} + "/" : std::string{}) +
+                       (test ? std::string{test->test_suite_name()} + "." + test->name() : std::string{"trace"}) + ".trace.json";
+    if (!gby::trace_log::instance().write_chrome_trace(path))
+        return "Trace: failed writing " + path + "\n";
+    return "Trace: " + path + "\n";
+#else
+    return "";
+#endif
+}
@@ -1,15 +1,27 @@
 
 #pragma once
 
+#include "AllocationCounters.h"
+#include "CpuTopology.h"
+#include "FastRandom.h"
+#include "KeyLog.h"
+#include "PerfCounters.h"
+
+#include "latency_histogram.h"
+#include "slot_map_stats.h"
+#include "slot_map_trace.h"
+
 #include <gtest/gtest.h>
 
+#include <sstream>
 #include <string>
 #include <array>
 #include <vector>
 #include <thread>
 #include <future>
-#include <random>
+#include <deque>
 #include <functional>
+#include <type_traits>
 
 constexpr size_t maxStrLen {50};
 
@@ -29,6 +41,19 @@ inline bool operator==(const TestObj &lhs, const TestObj &rhs)
            lhs._c == rhs._c;
 }
 
+// random string of up to maxStrLen alphanumeric characters
+inline std::string genStr()
+{
+    auto& randomEngine = threadRandom();
+    const auto len = pickIndex(randomEngine(), maxStrLen);
+
+    std::string s{};
+    s.reserve(len);
+    for (size_t i = 0; i < len; ++i)
+        s += alphaNum[pickIndex(randomEngine(), sizeof(alphaNum))];
+    return s;
+}
+
 template<size_t T>
 auto genTestObj()
 {
@@ -36,14 +61,10 @@ auto genTestObj()
 
     auto genTestObj = []
         {
-            auto len {rand()%maxStrLen};
-
-            std::string s{};
-            s.reserve(len);
-            for (int i = 0; i < len; ++i)
-                s += alphaNum[rand() % sizeof(alphaNum)];
-            
-            return TestObj{rand(), alphaNum[rand() % sizeof(alphaNum)], s};
+            auto& randomEngine = threadRandom();
+            const auto a = static_cast<int>(randomEngine() >> 33);
+            const auto b = alphaNum[pickIndex(randomEngine(), sizeof(alphaNum))];
+            return TestObj{a, b, genStr()};
         };
     std::generate_n(testObjInput.begin(), T, genTestObj);
     return testObjInput;
@@ -53,133 +74,295 @@ template <size_t T>
 auto genStrInput()
 {
     std::array<std::string, T> strInput {};
-
-    auto genStr = []
-        {
-            auto len {rand()%maxStrLen};
-
-            std::string s{};
-            s.reserve(len);
-            for (int i = 0; i < len; ++i)
-                s += alphaNum[rand() % sizeof(alphaNum)];
-            return s;
-        };
     std::generate_n(strInput.begin(), T, genStr);
     return strInput;
 }
 
-// returns pair<TimeInFunction, numberOfElementsErased>
-template <size_t writeCount, typename T, typename U, typename Z>
-std::pair<std::chrono::nanoseconds, size_t> writerEraserFnc(T &keys, std::atomic<size_t>& keysCount, U &map, Z genFunc)
+// a "- perf counters per <op_>" statistics line, empty when there are no counters
+inline std::string perfCountersLine(const PerfCounterValues& values_, const size_t opCount_, const std::string& op_)
+{
+    if (!values_.any() || opCount_ == 0)
+        return "";
+
+    std::ostringstream line;
+    line << "     - perf counters per " << op_ << ":";
+    values_.print(line, opCount_);
+    line << "\n";
+    return line.str();
+}
+
+// a "- heap per <op_>" statistics line, empty unless built with allocation counting
+inline std::string allocationsLine(const AllocationCounts& allocations_, const size_t opCount_, const std::string& op_)
+{
+    if (!allocationCountingEnabled || opCount_ == 0)
+        return "";
+
+    std::ostringstream line;
+    line << "     - heap per " << op_ << ":";
+    allocations_.print(line, opCount_);
+    line << "\n";
+    return line.str();
+}
+
+// "Engine counters:" lines of a map's stats(), empty unless built with GBY_SLOT_MAP_STATS
+template<typename Map>
+std::string statsLines(const Map& map_)
+{
+    if constexpr (!gby::slot_map_counters::enabled || !requires { map_.stats(); })
+        return "";
+    else
+    {
+        const auto stats = map_.stats();
+        std::ostringstream lines;
+        lines << "Engine counters:\n"
+              << "     - CAS failures: free list "  << stats.free_list_cas_failures
+              << ", fresh slot "                    << stats.fresh_slot_cas_failures
+              << ", size "                          << stats.size_cas_failures
+              << ", publish "                       << stats.publish_cas_failures
+              << ", drain restarts "                << stats.drain_restarts << "\n"
+              << "     - drains: "                  << stats.drains_succeeded << "/" << stats.drains_attempted << " succeeded"
+              << ", " << stats.elements_per_drain() << " elements per drain (max " << stats.max_elements_per_drain << ")"
+              << ", peak erase queue depth "        << stats.peak_erase_queue_depth << "\n"
+              << "     - growth events: "           << stats.growth_events
+              << ", erase lock waits: "             << stats.erase_lock_waits
+              << " (" << stats.erase_lock_wait_ns << " ns)\n";
+        return lines.str();
+    }
+}
+
+// Chrome trace-event timeline of the test's threads, when built with
+// GBY_SLOT_MAP_TRACE (see src/slot_map_trace.h): startTrace() drops what was
+// recorded before, traceLine() writes the trace to
+// $GBY_SLOTMAP_TRACE_DIR/<suite>.<test>.trace.json (the working directory by
+// default) and returns a "Trace:" line naming the file. Empty otherwise.
+void        startTrace();
+std::string traceLine();
+
+// std::async, on a thread pinned to cpu_ (unpinned for -1)
+template<typename Fnc, typename... Args>
+auto asyncPinned(const int cpu_, Fnc fnc_, Args... args_)
+{
+    return std::async(std::launch::async, [=]() mutable { pinCurrentThread(cpu_); return fnc_(args_...); });
+}
+
+// the threads' placement, as "Placement (policy): writers: cpu 0,1; readers: cpu 2"
+inline std::string placementLine(const PinningPolicy policy_, const std::vector<int>& cpus_,
+                                 const std::vector<std::pair<std::string, size_t>>& roles_)
+{
+    std::ostringstream line;
+    line << "Placement (" << pinningPolicyName(policy_) << "):";
+    auto first = cpus_.begin();
+    for (const auto& [role, count] : roles_)
+    {
+        line << (first == cpus_.begin() ? " " : "; ");
+        printPlacement(line, role, first, first + count);
+        first += count;
+    }
+    line << "\n";
+    return line.str();
+}
+
+// "- latency (ns): p50 ..., max ..." statistics line, empty when nothing was recorded
+inline std::string latencyLine(const gby::latency_histogram& latencies_, const std::string& op_)
+{
+    if (latencies_.count() == 0)
+        return "";
+
+    std::ostringstream line;
+    line << "     - " << op_ << " latency (ns):"
+         << " p50 "   << latencies_.percentile(50)
+         << ", p90 "  << latencies_.percentile(90)
+         << ", p99 "  << latencies_.percentile(99)
+         << ", p99.9 "<< latencies_.percentile(99.9)
+         << ", max "  << latencies_.max() << "\n";
+    return line.str();
+}
+
+// calls fnc_, recording how long it took into latencies_ and what it allocated
+// into allocations_, and as a span named op_ into the trace
+template<typename Fnc>
+auto timed(const char* op_, gby::latency_histogram& latencies_, AllocationCounts& allocations_, Fnc&& fnc_)
+{
+    gby::trace_span span {op_};
+    const auto allocationsStart = threadAllocationCounts();
+    const auto start  = std::chrono::steady_clock::now();
+    auto       record = [&]
+    {
+        latencies_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start).count());
+        allocations_ += threadAllocationCounts() - allocationsStart;
+    };
+    if constexpr (std::is_void_v<std::invoke_result_t<Fnc>>)
+    {
+        fnc_();
+        record();
+    }
+    else
+    {
+        auto result = fnc_();
+        record();
+        return result;
+    }
+}
+
+// tuple<TimeInFunction, numberOfElementsErased, PerfCounters, insertLatencies, eraseLatencies, Allocations>
+using WriterResult = std::tuple<std::chrono::nanoseconds, size_t, PerfCounterValues, gby::latency_histogram, gby::latency_histogram,
+                                AllocationCounts>;
+// tuple<TimeInFunction, numberOfElementsErased, PerfCounters, eraseLatencies, Allocations>
+using EraserResult = std::tuple<std::chrono::nanoseconds, size_t, PerfCounterValues, gby::latency_histogram, AllocationCounts>;
+// tuple<TimeInFunction, numberOfElementsRead, numberOfErrors, PerfCounters, readLatencies, Allocations>
+using ReaderResult = std::tuple<std::chrono::nanoseconds, size_t, size_t, PerfCounterValues, gby::latency_histogram,
+                                AllocationCounts>;
+
+// One step of a writer's operation stream: insert value, then - if erase is
+// set - erase one of the writer's live keys, picked by eraseDraw.
+template<typename V>
+struct WriteOp
+{
+    V        value;
+    bool     erase     {};
+    uint64_t eraseDraw {};
+};
+
+// A writer's whole operation stream, generated before it starts measuring so
+// that neither genFunc_ nor the random draws are part of the measurements.
+// Every write is followed by an erase with a chance of 1 in eraseOneIn_ (0 for never).
+template<typename Z>
+auto makeWriteStream(const size_t count_, Z& genFunc_, const unsigned eraseOneIn_, const uint64_t seed_)
+{
+    using V = std::decay_t<decltype(genFunc_())>;
+
+    Xoshiro256 randomEngine {seed_};
+    std::vector<WriteOp<V>> stream {};
+    stream.reserve(count_);
+    for (size_t i = 0; i < count_; ++i)
+    {
+        auto value = genFunc_();
+        const bool erase = eraseOneIn_ != 0 && pickIndex(randomEngine(), eraseOneIn_) == 0;
+        stream.push_back({std::move(value), erase, erase ? randomEngine() : 0});
+    }
+    return stream;
+}
+
+template <size_t writeCount, typename U, typename Z>
+WriterResult writerEraserFnc(KeyLog<typename U::key_type>& keys, U &map, Z genFunc, const uint64_t seed)
 {
+    gby::trace_thread_name("writer");
+    auto stream = makeWriteStream(writeCount, genFunc, 10, seed);
+    std::vector<typename U::key_type> liveKeys {};
+    liveKeys.reserve(writeCount);
+
     long erasedCount {};
+    gby::latency_histogram insertLatencies {};
+    gby::latency_histogram eraseLatencies {};
+    AllocationCounts allocations {};
+    PerfCounters perf;
+    perf.start();
     auto timeStart = std::chrono::high_resolution_clock::now();
-    for(size_t count{}; count < writeCount; ++count)    
+    for (auto& op : stream)
     {
-        keys.emplace_back(map.insert(genFunc()));
-        keysCount.fetch_add(1);
+        const auto key = timed("insert", insertLatencies, allocations, [&] { return map.insert(std::move(op.value)); });
+        keys.append(key);
+        liveKeys.push_back(key);
 
-        if (auto chanceToDelete = rand() % 10; chanceToDelete == 1)
+        if (op.erase)
         {
-            auto sz = keysCount.load();
-            if (sz > 0)
-            {
-                auto key_it = keys.begin();
-                std::advance(key_it, rand() % sz);
-                map.erase(*key_it);
-                keysCount.fetch_sub(1);
-                keys.erase(key_it);
-                erasedCount++;
-            }
+            const size_t idx = pickIndex(op.eraseDraw, liveKeys.size());
+            timed("erase", eraseLatencies, allocations, [&] { map.erase(liveKeys[idx]); });
+            liveKeys[idx] = liveKeys.back();
+            liveKeys.pop_back();
+            erasedCount++;
         }
     }
     auto timeEnd = std::chrono::high_resolution_clock::now();
-    return {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart), erasedCount};
+    perf.stop();
+    return {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart), erasedCount, perf.read(),
+            insertLatencies, eraseLatencies, allocations};
 }
 
-template <size_t writeCount, typename T, typename U, typename Z>
-std::pair<std::chrono::nanoseconds, size_t> writerFnc (T &keys, std::atomic<size_t>& keysCount, U &map, Z genFunc)
+template <size_t writeCount, typename U, typename Z>
+WriterResult writerFnc (KeyLog<typename U::key_type>& keys, U &map, Z genFunc, const uint64_t seed)
 {
+    gby::trace_thread_name("writer");
+    auto stream = makeWriteStream(writeCount, genFunc, 0, seed);
+
+    gby::latency_histogram insertLatencies {};
+    AllocationCounts allocations {};
+    PerfCounters perf;
+    perf.start();
     auto timeStart = std::chrono::high_resolution_clock::now();
-    long count {};
-    while(count++ < writeCount)
-    {
-        keys.push_back(map.insert(genFunc()));
-        keysCount.fetch_add(1);
-    }
+    for (auto& op : stream)
+        keys.append(timed("insert", insertLatencies, allocations, [&] { return map.insert(std::move(op.value)); }));
     auto timeEnd = std::chrono::high_resolution_clock::now();
+    perf.stop();
     
-    return {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart), 0};
+    return {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart), 0, perf.read(), insertLatencies, {},
+            allocations};
 }
 
-template <typename T, typename U, typename Z>
-std::pair<std::chrono::nanoseconds, size_t> eraserFnc (T &keys, std::atomic<size_t>& keySize, U &map, std::atomic<bool> &readFlag)
+// erases random keys of the log, already erased ones included, until readFlag is cleared
+template <typename U>
+EraserResult eraserFnc (const KeyLog<typename U::key_type>& keys, U &map, std::atomic<bool> &readFlag, const uint64_t seed)
 {
+    gby::trace_thread_name("eraser");
     long count {};
     std::chrono::nanoseconds sleepLen {1000};
+    Xoshiro256 randomEngine {seed};
 
-    std::uniform_int_distribution<size_t> idxDistribution(1, 9999999);
-    std::mt19937 random_number_engine; // pseudorandom number generator
-    auto idxGenerator = std::bind(idxDistribution, random_number_engine);
-
+    // the counters only run while erasing, not while sleeping
+    gby::latency_histogram eraseLatencies {};
+    AllocationCounts allocations {};
+    PerfCounters perf;
     auto timeStart = std::chrono::high_resolution_clock::now();
 
     int sleepCount = 0;
-    while(readFlag)
+    while (readFlag.load(std::memory_order_relaxed))
     {
         std::this_thread::sleep_for(sleepLen);
         sleepCount++;
-        auto sz = keySize.load();
-        if (sz > 0)
+        perf.start();
+        if (const auto sz = keys.published(); sz > 0)
         {
-            size_t key_idx {idxGenerator()%sz};
-            keySize.fetch_sub(1);
-            map.erase(keys[key_idx]);
+            const auto& key = keys[pickIndex(randomEngine(), sz)];
+            timed("erase", eraseLatencies, allocations, [&] { map.erase(key); });
             count++;
         }
+        perf.stop();
     }
     auto timeEnd = std::chrono::high_resolution_clock::now();
     
     std::chrono::nanoseconds timeSlept {sleepCount * sleepLen};
     std::chrono::nanoseconds totalTime {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart)};
     auto overallTime = totalTime - timeSlept;
-    return {overallTime, count};
+    return {overallTime, count, perf.read(), eraseLatencies, allocations};
 }
 
-template<typename T, typename U>
-std::tuple<std::chrono::nanoseconds, size_t, size_t> readerFnc(const T &keys, std::atomic<size_t>& keySize, U &map, std::atomic<bool> &readFlag)
+// finds random keys of the log, erased ones included, until readFlag is cleared
+template<typename U>
+ReaderResult readerFnc(const KeyLog<typename U::key_type>& keys, U &map, std::atomic<bool> &readFlag, const uint64_t seed)
 {
+    gby::trace_thread_name("reader");
     size_t readCount {};
     size_t errorCount {};
+    gby::latency_histogram readLatencies {};
+    AllocationCounts allocations {};
+    Xoshiro256 randomEngine {seed};
 
-    std::uniform_int_distribution<size_t> idxDistribution(1, 9999999);
-    std::mt19937 random_number_engine; // pseudorandom number generator
-    auto idxGenerator = std::bind(idxDistribution, random_number_engine);
-
+    PerfCounters perf;
+    perf.start();
     auto timeStart = std::chrono::high_resolution_clock::now();
-    while (readFlag)
+    while (readFlag.load(std::memory_order_relaxed))
     {
-        size_t idx;
+        const size_t keyMax = keys.published();
+        if (keyMax == 0)
+            continue;
+
+        const auto& key = keys[pickIndex(randomEngine(), keyMax)];
         try
         {
-            size_t keyMax = keySize.load(std::memory_order_acquire);
-            while (keyMax == 0)
-                keyMax = keySize.load(std::memory_order_acquire);
-
-            size_t randomIdx = idxGenerator();
-            idx = randomIdx % keyMax;
-            auto key = keys[idx];
-            try
-            {
-                const auto& var = map.find(key);
-                __asm("");
-                readCount++;
-            }
-            catch([[maybe_unused]] std::exception& e)
-            {
-                std::cerr << "nested exception: " << e.what() << std::endl;
-                errorCount++;
-            }
+            const auto& var = timed("find", readLatencies, allocations, [&] { return map.find(key); });
+            __asm("");
+            readCount++;
         }
         catch([[maybe_unused]] std::exception& e)
         {
@@ -188,8 +371,96 @@ std::tuple<std::chrono::nanoseconds, size_t, size_t> readerFnc(const T &keys, st
         }
     }
     auto timeEnd = std::chrono::high_resolution_clock::now();
+    perf.stop();
 
-    return {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart), readCount, errorCount};
+    return {std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd-timeStart), readCount, errorCount, perf.read(), readLatencies,
+            allocations};
+}
+
+
+// ThreadCount threads insert (try_insert), find, erase and iterate at once,
+// OpsPerThread rounds each, on a map set up for real-time use, and none of it
+// may allocate. The allocations are only checked when they are counted, which
+// GBY_SlotMap_RealTimeTests always does.
+template <size_t ThreadCount, size_t OpsPerThread, typename T>
+void test_realTimeNoAllocations(T& map)
+{
+    std::cout << "-------------   Starting real-time allocation test   -------------" << std::endl;
+
+    // every thread keeps up to its share of half the map alive, and drains the
+    // erase queue every DrainInterval rounds (the non-blocking drains mostly
+    // lose to the iterating threads), so that almost every insert finds a slot
+    const size_t liveKeysMax = std::max<size_t>(1, map.capacity() / (2 * ThreadCount));
+    constexpr size_t DrainInterval = 64;
+
+    // everything the threads need is allocated before they start counting
+    auto worker = [&map, liveKeysMax](const uint64_t seed_)
+    {
+        Xoshiro256 randomEngine {seed_};
+        std::vector<typename T::key_type> liveKeys {};
+        liveKeys.reserve(OpsPerThread);
+        size_t failedInserts {};
+
+        const AllocationCounter counter {};
+        for (size_t i = 0; i < OpsPerThread; ++i)
+        {
+            if (const auto key = map.try_insert(static_cast<typename T::value_type>(i)))
+                liveKeys.push_back(*key);
+            else
+                ++failedInserts;
+
+            if (!liveKeys.empty())
+            {
+                const size_t idx = pickIndex(randomEngine(), liveKeys.size());
+                EXPECT_TRUE(map.find(liveKeys[idx]).has_value());
+                if (liveKeys.size() > liveKeysMax || (randomEngine() & 1))
+                {
+                    map.erase(liveKeys[idx]);
+                    liveKeys[idx] = liveKeys.back();
+                    liveKeys.pop_back();
+                }
+            }
+
+            if (i % 1024 == 0)
+                map.iterate_map([](const auto&) {});
+            if (i % DrainInterval == 0)
+                map.template drainEraseQueue<true>();
+        }
+        return std::pair{counter.read(), failedInserts};
+    };
+
+    std::vector<std::future<std::pair<AllocationCounts, size_t>>> threads {};
+    for (size_t i = 0; i < ThreadCount; ++i)
+        threads.push_back(std::async(std::launch::async, worker, uint64_t{1 + i}));
+
+    AllocationCounts allocations {};
+    size_t failedInserts {};
+    for (auto& thread : threads)
+    {
+        const auto [threadAllocations, threadFailedInserts] = thread.get();
+        allocations   += threadAllocations;
+        failedInserts += threadFailedInserts;
+    }
+
+    if constexpr (allocationCountingEnabled)
+    {
+        EXPECT_EQ(0, allocations.allocations);
+        EXPECT_EQ(0, allocations.bytes);
+    }
+    // the stress is meant for the success path - the odd insert may still lose
+    // its claim to the other threads or find the queue not drained yet
+    EXPECT_LE(failedInserts, ThreadCount * OpsPerThread / 100);
+
+    std::cout << "Real-time allocation statistics:\n"
+              << "     - threads: " << ThreadCount << ", rounds per thread: " << OpsPerThread << "\n"
+              << "     - failed try_inserts: " << failedInserts << "\n"
+              << "     - allocations: ";
+    if constexpr (allocationCountingEnabled)
+        std::cout << allocations.allocations << " (" << allocations.bytes << " bytes)\n";
+    else
+        std::cout << "not counted\n";
+    std::cout << statsLines(map)
+              << "-------------   Finished real-time allocation test   -------------" << std::endl;
 }
 
 
@@ -202,51 +473,70 @@ void test_SPMC(T& map, U genKeyFunctor, const bool enableErase)
         std::cout << "-------------   Starting Single Producer Multi Consumer test w/out Erases  -------------" << std::endl;
     
     EXPECT_TRUE(map.empty());
+    startTrace();
 
-    std::vector<typename T::key_type> keys{};
-    keys.reserve(WriteCount);
-    std::atomic<size_t> keysCount{};
+    KeyLog<typename T::key_type> keys {WriteCount};
 
-    auto writer_fut = std::async(std::launch::async,
-                                 (enableErase) ? writerEraserFnc<WriteCount, decltype(keys), T, U> 
-                                               : writerFnc<WriteCount, decltype(keys), T, U>, 
-                                 std::ref(keys), std::ref(keysCount), std::ref(map), genKeyFunctor);
+    // the writer goes first, then the readers
+    const auto pinning   = pinningPolicyFromEnv();
+    const auto placement = CpuTopology::get().placement(pinning, 1 + ReaderCount);
+
+    auto writer_fut = asyncPinned(placement[0],
+                                  (enableErase) ? writerEraserFnc<WriteCount, T, U> 
+                                                : writerFnc<WriteCount, T, U>, 
+                                  std::ref(keys), std::ref(map), genKeyFunctor, uint64_t{1});
 
     std::atomic<bool> readFlag{true};
-    std::vector<std::future<std::tuple<std::chrono::nanoseconds, size_t, size_t>>> readers{};
+    std::vector<std::future<ReaderResult>> readers{};
     for (size_t i {}; i < ReaderCount; ++i)
-        readers.push_back(std::async(std::launch::async, 
-                                     readerFnc<decltype(keys), T>, 
-                                     std::ref(keys), std::ref(keysCount), std::ref(map), std::ref(readFlag)) );
+        readers.push_back(asyncPinned(placement[1 + i],
+                                      readerFnc<T>, 
+                                      std::ref(keys), std::ref(map), std::ref(readFlag), uint64_t{2 + i}) );
 
-    auto [writingTimeInNanos, erasedCount] = writer_fut.get();
+    auto [writingTimeInNanos, erasedCount, writerPerf, insertLatencies, eraseLatencies, writerAllocations] = writer_fut.get();
 
     readFlag = false;
 
     std::chrono::nanoseconds totalReaderTimeInNanos {};
     size_t totalReads {};
+    PerfCounterValues readersPerf {};
+    gby::latency_histogram readLatencies {};
+    AllocationCounts readersAllocations {};
     for (auto& reader : readers)
     {
-        auto [readerTimeInNanos, readCount, errorCount] = reader.get();
+        auto [readerTimeInNanos, readCount, errorCount, readerPerf, readerLatencies, readerAllocations] = reader.get();
 
         EXPECT_EQ(0, errorCount);
         totalReaderTimeInNanos += readerTimeInNanos;
         totalReads += readCount;
+        readersPerf += readerPerf;
+        readLatencies.merge(readerLatencies);
+        readersAllocations += readerAllocations;
     }
 
     std::cout << "Single Producer Multi Consumer statistics:"                     << "\n"
+              << placementLine(pinning, placement, {{"writer", 1}, {"readers", ReaderCount}})
               << "Writer:"                                                        << "\n"
               << "     - total elements written: " << WriteCount                  << "\n"
               << "     - total elements erased: "  << erasedCount                 << "\n"
               << "     - time (in nanoseconds): " << writingTimeInNanos.count()
                                             << " averaging " << (WriteCount == 0 ? 0 : writingTimeInNanos.count()/WriteCount)
                                             << " nanos per write.\n"
+              << latencyLine(insertLatencies, "write")
+              << latencyLine(eraseLatencies, "erase")
+              << perfCountersLine(writerPerf, WriteCount + erasedCount, "write/erase")
+              << allocationsLine(writerAllocations, WriteCount + erasedCount, "write/erase")
               << "Readers:"                                                       << "\n"
               << "     - concurrent readers count: " << ReaderCount               << "\n"
               << "     - Total elements read: "      << totalReads                << "\n"
               << "     - time (in nanoseconds): "   << totalReaderTimeInNanos.count()
                                     << " averaging " << totalReaderTimeInNanos.count()/totalReads
                                     << " nanos per read."                        << "\n"
+              << latencyLine(readLatencies, "read")
+              << perfCountersLine(readersPerf, totalReads, "read")
+              << allocationsLine(readersAllocations, totalReads, "read")
+              << statsLines(map)
+              << traceLine()
             << std::endl;
 
     if (enableErase)
@@ -261,104 +551,126 @@ void test_MPMC(T& map, U genKeyFunctor)
 {
     std::cout << "-------------   Starting Multi Producer Multi Consumer test   -------------" << std::endl;
     EXPECT_TRUE(map.empty());
+    startTrace();
+
+    // one key log per writer, the erasers and readers pick theirs round robin
+    std::deque<KeyLog<typename T::key_type>> keyLogs{};
+    for (size_t i {}; i < WriterCount; ++i)
+        keyLogs.emplace_back(WriteCountPerWriter);
 
-    std::vector<std::vector<typename T::key_type>> vecOfKeys{};
-    vecOfKeys.reserve(WriterCount);
+    // writers go first, then the erasers and then the readers
+    const auto erasersCount = std::min(EraserCount, WriterCount);
+    const auto pinning      = pinningPolicyFromEnv();
+    const auto placement    = CpuTopology::get().placement(pinning, WriterCount + erasersCount + ReaderCount);
 
-    std::vector<std::atomic<size_t>> vecOfkeysLen(WriterCount);
+    // every thread gets a seed of its own
+    uint64_t seed {1};
 
-    std::vector<std::future<std::pair<std::chrono::nanoseconds, size_t>>> writers{};
+    std::vector<std::future<WriterResult>> writers{};
     writers.reserve(WriterCount);
     for (size_t i {}; i < WriterCount; ++i)
-    {
-        auto& atomicSize = vecOfkeysLen[i];
-        atomicSize = 0;
-
-        vecOfKeys.emplace_back();
-        auto& keyVec = vecOfKeys.back();
-        keyVec.reserve(WriteCountPerWriter);
-
-        writers.emplace_back(std::async(std::launch::async,
-                                writerFnc<WriteCountPerWriter, std::vector<typename T::key_type>, T, U>, 
-                                std::ref(keyVec), std::ref(atomicSize), std::ref(map), genKeyFunctor));
-    }
+        writers.emplace_back(asyncPinned(placement[i],
+                                writerFnc<WriteCountPerWriter, T, U>, 
+                                std::ref(keyLogs[i]), std::ref(map), genKeyFunctor, seed++));
 
     std::atomic<bool> readFlag{true};
 
-    std::vector<std::future<std::pair<std::chrono::nanoseconds, size_t>>> erasers{};
-    auto erasersCount = std::min(EraserCount, WriterCount);
-    if (erasersCount > 0)
-    {
-        erasers.reserve(erasersCount);
-        for (size_t i=0; i < erasersCount; ++i)
-            erasers.emplace_back(std::async(std::launch::async,
-                                            eraserFnc<std::vector<typename T::key_type>, T, U>,
-                                            std::ref(vecOfKeys[i]), std::ref(vecOfkeysLen[i]), std::ref(map), std::ref(readFlag)) );
-    }
+    std::vector<std::future<EraserResult>> erasers{};
+    erasers.reserve(erasersCount);
+    for (size_t i=0; i < erasersCount; ++i)
+        erasers.emplace_back(asyncPinned(placement[WriterCount + i],
+                                         eraserFnc<T>,
+                                         std::cref(keyLogs[i]), std::ref(map), std::ref(readFlag), seed++) );
 
-    std::vector<std::future<std::tuple<std::chrono::nanoseconds, size_t, size_t>>> readers{};
+    std::vector<std::future<ReaderResult>> readers{};
     readers.reserve(ReaderCount);
     for (size_t i {}; i < ReaderCount; ++i)
-    {
-        auto idx = rand()%vecOfKeys.size();
-        readers.emplace_back(std::async(std::launch::async,
-                                        readerFnc<std::vector<typename T::key_type>, T>,
-                                        std::ref(vecOfKeys[idx]), std::ref(vecOfkeysLen[idx]), std::ref(map), std::ref(readFlag)) );
-
-    }
+        readers.emplace_back(asyncPinned(placement[WriterCount + erasersCount + i],
+                                         readerFnc<T>,
+                                         std::cref(keyLogs[i % WriterCount]), std::ref(map), std::ref(readFlag), seed++) );
 
     size_t totalWrites {WriterCount*WriteCountPerWriter};
 
     std::chrono::nanoseconds totalWriteInNanos {};
+    PerfCounterValues writersPerf {};
+    gby::latency_histogram insertLatencies {};
+    AllocationCounts writersAllocations {};
     for (auto& writer : writers)
     {
-        auto [writingTimeInNanos, erasedCount] = writer.get();
+        auto [writingTimeInNanos, erasedCount, writerPerf, writerLatencies, writerEraseLatencies, writerAllocations] = writer.get();
 
         EXPECT_EQ(0, erasedCount);
         totalWriteInNanos += writingTimeInNanos;
+        writersPerf += writerPerf;
+        insertLatencies.merge(writerLatencies);
+        writersAllocations += writerAllocations;
     }
     readFlag = false;
 
     std::chrono::nanoseconds totalReaderTimeInNanos {};
     size_t totalReads {};
+    PerfCounterValues readersPerf {};
+    gby::latency_histogram readLatencies {};
+    AllocationCounts readersAllocations {};
     for (auto& reader : readers)
     {
-        auto [readerTimeInNanos, readCount, errorCount] = reader.get();
+        auto [readerTimeInNanos, readCount, errorCount, readerPerf, readerLatencies, readerAllocations] = reader.get();
 
         EXPECT_EQ(0, errorCount);
         totalReaderTimeInNanos += readerTimeInNanos;
         totalReads += readCount;
+        readersPerf += readerPerf;
+        readLatencies.merge(readerLatencies);
+        readersAllocations += readerAllocations;
     }
 
     std::chrono::nanoseconds totalEraserTimeInNanos {};
     size_t totalErases {};
+    PerfCounterValues erasersPerf {};
+    gby::latency_histogram eraseLatencies {};
+    AllocationCounts erasersAllocations {};
     for (auto& eraser : erasers)
     {
-        auto [eraserTimeInNanos, eraseCount] = eraser.get();
+        auto [eraserTimeInNanos, eraseCount, eraserPerf, eraserLatencies, eraserAllocations] = eraser.get();
         EXPECT_GT(eraserTimeInNanos, static_cast<std::chrono::nanoseconds>(0));
         totalEraserTimeInNanos += eraserTimeInNanos;
         totalErases += eraseCount;
+        erasersPerf += eraserPerf;
+        eraseLatencies.merge(eraserLatencies);
+        erasersAllocations += eraserAllocations;
     }
 
     std::cout << "Multi Producer Multi Consumer statistics:"                      << "\n"
+              << placementLine(pinning, placement, {{"writers", WriterCount}, {"erasers", erasersCount}, {"readers", ReaderCount}})
               << "Writers:"                                                       << "\n"
               << "     - concurrent writers count: " << WriterCount               << "\n"
               << "     - total elements written: "   << totalWrites               << "\n"
               << "     - time (in nanoseconds): "   << totalWriteInNanos.count()
                                      << " averaging "<< (totalWrites == 0 ? 0 : totalWriteInNanos.count()/totalWrites)
                                      << " nanos per write."      << "\n"
+              << latencyLine(insertLatencies, "write")
+              << perfCountersLine(writersPerf, totalWrites, "write")
+              << allocationsLine(writersAllocations, totalWrites, "write")
               << "Erasers:"                                                       << "\n"
               << "     - concurrent erasers count: " << erasersCount              << "\n"
               << "     - total elements erased: "    << totalErases               << "\n"
               << "     - time (in nanoseconds): "   << totalEraserTimeInNanos.count()
                                      << " averaging "<< (totalErases == 0 ? 0 : totalEraserTimeInNanos.count()/totalErases)
                                      << " nanos per erase."      << "\n"
+              << latencyLine(eraseLatencies, "erase")
+              << perfCountersLine(erasersPerf, totalErases, "erase")
+              << allocationsLine(erasersAllocations, totalErases, "erase")
               << "Readers:"                                                       << "\n"
               << "     - concurrent readers count: " << ReaderCount               << "\n"
               << "     - Total elements read: "      << totalReads                << "\n"
               << "     - time (in nanoseconds): "   << totalReaderTimeInNanos.count()
                                      << " averaging "<< (totalReads == 0 ? 0 : totalReaderTimeInNanos.count()/totalReads)
                                      << " nanos per read."       << "\n"
+              << latencyLine(readLatencies, "read")
+              << perfCountersLine(readersPerf, totalReads, "read")
+              << allocationsLine(readersAllocations, totalReads, "read")
+              << statsLines(map)
+              << traceLine()
               << std::endl;
 
         std::cout << "-------------   Finished Multi Producer Multi Consumer test  -------------" << std::endl;
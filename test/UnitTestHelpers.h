@@ -4,9 +4,14 @@
 #include <gtest/gtest.h>
 
 #include "locked_slot_map.h"
+#include "slot_map_stats.h"
+#include "slot_map_result.h"
 
 #include <string>
 #include <array>
+#include <chrono>
+#include <thread>
+#include <utility>
 
 
 struct TestObj
@@ -94,4 +99,177 @@ void addQueryAndRemoveElement_Locked (T& map, std::array<U, 3>& vals)
     EXPECT_EQ(0, map.size());
 
     EXPECT_TRUE(map.empty());
-}
\ No newline at end of file
+}
+
+// for the baseline maps, which only implement insert/find/erase/iterate_map
+template <typename T, typename U>
+void addQueryAndRemoveElement_Baseline(T& map, std::array<U, 3>& vals)
+{
+    EXPECT_TRUE(map.empty());
+
+    auto key1 = map.insert(vals[0]);
+    auto key2 = map.insert(vals[1]);
+    auto key3 = map.insert(vals[2]);
+
+    EXPECT_EQ(3, map.size());
+    EXPECT_EQ(vals[0], (*map.find(key1)).get());
+    EXPECT_EQ(vals[1], (*map.find(key2)).get());
+    EXPECT_EQ(vals[2], (*map.find(key3)).get());
+
+    size_t iterated {};
+    map.iterate_map([&iterated](const U&) { ++iterated; });
+    EXPECT_EQ(3, iterated);
+
+    EXPECT_TRUE(map.erase(key2));
+    EXPECT_FALSE(map.erase(key2));
+    EXPECT_EQ(vals[0], (*map.find(key1)).get());
+    EXPECT_FALSE(map.find(key2).has_value());
+    EXPECT_EQ(vals[2], (*map.find(key3)).get());
+    EXPECT_EQ(2, map.size());
+
+    EXPECT_TRUE(map.erase(key1));
+    EXPECT_TRUE(map.erase(key3));
+    EXPECT_FALSE(map.find(key1).has_value());
+    EXPECT_FALSE(map.find(key3).has_value());
+    EXPECT_EQ(0, map.size());
+
+    EXPECT_TRUE(map.empty());
+}
+
+
+// fills up a fixed sized map, then checks that inserting blocks until an erase frees a slot
+template <size_t Size, typename T, typename U>
+void insertWaitOnFullMap(T& map, const U& val)
+{
+    using namespace std::chrono_literals;
+
+    std::vector<typename T::key_type> keys{};
+    for (size_t i = 0; i < Size; ++i)
+        keys.push_back(map.insert(val));
+
+    EXPECT_EQ(Size, map.size());
+    EXPECT_THROW(map.insert(val), std::length_error);
+    EXPECT_FALSE(map.try_insert_for(val, 10ms).has_value());
+
+    std::thread eraser([&map, &keys] { 
+                                        std::this_thread::sleep_for(20ms); 
+                                        map.erase(keys[0]); 
+                                     });
+    auto key = map.insert_wait(val);
+    eraser.join();
+
+    EXPECT_EQ(Size, map.size());
+    EXPECT_EQ(val, (*map.find(key)).get());
+    EXPECT_FALSE(map.find(keys[0]).has_value());
+
+    eraser = std::thread([&map, &keys] { 
+                                        std::this_thread::sleep_for(20ms); 
+                                        map.erase(keys[1]); 
+                                     });
+    auto optKey = map.try_insert_for(val, 10s);
+    eraser.join();
+
+    ASSERT_TRUE(optKey.has_value());
+    EXPECT_EQ(val, (*map.find(*optKey)).get());
+    EXPECT_EQ(Size, map.size());
+}
+
+
+// fills up a map that can't grow with try_insert, then checks that inserting fails
+// without growing the map, until an erase frees a slot
+template <size_t Size, typename T, typename U>
+void tryInsertOnFullMap(T& map, const U& val)
+{
+    std::vector<typename T::key_type> keys{};
+    for (size_t i = 0; i < Size; ++i)
+    {
+        auto key = map.try_insert(val);
+        ASSERT_TRUE(key.has_value());
+        keys.push_back(*key);
+    }
+
+    const auto capacity = map.capacity();
+    EXPECT_EQ(Size, map.size());
+    EXPECT_FALSE(map.try_insert(val).has_value());
+    EXPECT_THROW(map.insert(val), std::length_error);
+    EXPECT_EQ(capacity, map.capacity());
+
+    map.erase(keys[0]);
+    auto key = map.try_insert(val, 1);
+    ASSERT_TRUE(key.has_value());
+    EXPECT_EQ(val, (*map.find(*key)).get());
+    EXPECT_FALSE(map.find(keys[0]).has_value());
+    EXPECT_EQ(Size, map.size());
+    EXPECT_EQ(capacity, map.capacity());
+}
+
+// fills up a map that can't grow with insert_nothrow, checking the errors
+// lookup and insert_nothrow report along the way
+template <size_t Size, typename T, typename U>
+void nothrowLookupAndInsert(T& map, const U& val)
+{
+    static_assert(noexcept(map.lookup(std::declval<typename T::key_type>())));
+
+    std::vector<typename T::key_type> keys{};
+    for (size_t i = 0; i < Size; ++i)
+    {
+        auto key = map.insert_nothrow(val);
+        ASSERT_TRUE(key.has_value());
+        keys.push_back(*key);
+    }
+
+    auto full = map.insert_nothrow(val);
+    ASSERT_FALSE(full);
+    EXPECT_EQ(gby::slot_map_errc::full, full.error());
+
+    auto found = map.lookup(keys[0]);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(val, found->get());
+
+    typename T::key_type outOfRange {keys[0]};
+    outOfRange.first = static_cast<decltype(outOfRange.first)>(map.capacity() + 1);
+    EXPECT_EQ(gby::slot_map_errc::out_of_range, map.lookup(outOfRange).error());
+    EXPECT_EQ(gby::slot_map_errc::out_of_range, std::as_const(map).lookup(outOfRange).error());
+    EXPECT_FALSE(map.find(outOfRange).has_value());
+
+    map.erase(keys[0]);
+    EXPECT_EQ(gby::slot_map_errc::stale_key, map.lookup(keys[0]).error());
+    EXPECT_TRUE(map.lookup(keys[1]).has_value());
+    EXPECT_TRUE(map.insert_nothrow(val).has_value());
+}
+
+
+// inserts and then erases Count elements one by one, all on this thread, and checks
+// what the map's counters recorded - all zeros unless built with GBY_SLOT_MAP_STATS
+template <size_t Count, typename T>
+void checkSingleThreadedStats(T& map)
+{
+    std::vector<typename T::key_type> keys{};
+    for (size_t i = 0; i < Count; ++i)
+        keys.push_back(map.insert(static_cast<typename T::value_type>(i)));
+    for (const auto& key : keys)
+        map.erase(key);
+
+    const auto stats = map.stats();
+    if constexpr (!gby::slot_map_counters::enabled)
+    {
+        EXPECT_EQ(0, stats.drains_attempted);
+        EXPECT_EQ(0, stats.elements_drained);
+        EXPECT_EQ(0, stats.peak_erase_queue_depth);
+        return;
+    }
+
+    // nothing to contend with: every CAS and lock succeeds right away
+    EXPECT_EQ(0, stats.free_list_cas_failures + stats.fresh_slot_cas_failures + stats.size_cas_failures +
+                 stats.publish_cas_failures + stats.drain_restarts);
+    EXPECT_EQ(0, stats.erase_lock_waits);
+    EXPECT_EQ(0, stats.erase_lock_wait_ns);
+
+    // and every erase is drained on the spot
+    EXPECT_EQ(Count, stats.drains_attempted);
+    EXPECT_EQ(Count, stats.drains_succeeded);
+    EXPECT_EQ(Count, stats.elements_drained);
+    EXPECT_EQ(1, stats.max_elements_per_drain);
+    EXPECT_EQ(1, stats.peak_erase_queue_depth);
+    EXPECT_DOUBLE_EQ(1, stats.elements_per_drain());
+}
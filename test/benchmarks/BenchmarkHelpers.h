@@ -0,0 +1,107 @@
+
+#pragma once
+
+#include "../AllocationCounters.h"
+#include "../PerfCounters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+// map shared by all the threads of a multi-threaded benchmark, 
+// created/destroyed by thread 0 (before/after the timed loop).
+template<typename Map>
+std::unique_ptr<Map> sharedMap {};
+
+// keys of the elements inserted into sharedMap during setup
+template<typename Map>
+std::vector<typename Map::key_type> sharedKeys {};
+
+// creates a map able to hold at least capacity_ elements without growing
+template<typename Map>
+std::unique_ptr<Map> makeMap(const size_t capacity_)
+{
+    if constexpr (requires { Map(capacity_); })
+    {
+        return std::make_unique<Map>(capacity_);
+    }
+    else
+    {
+        auto map = std::make_unique<Map>();
+        if constexpr (requires { map->reserve(capacity_); })
+            map->reserve(capacity_);
+        return map;
+    }
+}
+
+// the gby maps return an optional from find, the SG14 based ones an iterator
+template<typename Map>
+bool contains(Map& map_, const typename Map::key_type& key_)
+{
+    if constexpr (requires { map_.find(key_).has_value(); })
+        return map_.find(key_).has_value();
+    else
+        return map_.find(key_) != map_.end();
+}
+
+// blocking drain of the map's erase queue, maps without one erase in place
+template<typename Map>
+void flushEraseQueue(Map& map_)
+{
+    if constexpr (requires { map_.template drainEraseQueue<true>(); })
+        map_.template drainEraseQueue<true>();
+    else if constexpr (requires { map_.template flushEraseQueue<true>(); })
+        map_.template flushEraseQueue<true>();
+}
+
+// Reports the perf counters of the calling thread, per item processed. In multi
+// threaded benchmarks the counts of all the threads are summed and divided by
+// all their iterations, so they stay per item.
+inline void setPerfCounters(benchmark::State& state, const PerfCounters& perf_, const double itemsPerIteration_ = 1)
+{
+    const auto values = perf_.read();
+    for (size_t i = 0; i < values.counts.size(); ++i)
+    {
+        if (values.counts[i])
+            state.counters[std::string{perfEventName(allPerfEvents[i])} + "_per_item"] =
+                benchmark::Counter(*values.counts[i] / itemsPerIteration_, benchmark::Counter::kAvgIterations);
+    }
+}
+
+// Reports the heap allocations of the calling thread per item processed (summed
+// over the threads as the perf counters are), when built with allocation counting.
+// Anything above 0 in a steady state operation is an allocation to hunt down.
+inline void setAllocationCounters(benchmark::State& state, const AllocationCounter& allocations_,
+                                  const double itemsPerIteration_ = 1)
+{
+    if (!allocationCountingEnabled)
+        return;
+
+    const auto counts = allocations_.read();
+    state.counters["allocs_per_item"] =
+        benchmark::Counter(counts.allocations / itemsPerIteration_, benchmark::Counter::kAvgIterations);
+    state.counters["alloc_bytes_per_item"] =
+        benchmark::Counter(counts.bytes / itemsPerIteration_, benchmark::Counter::kAvgIterations);
+}
+
+// pause/resume the timer, the perf counters and the allocation counting,
+// around setup done within the timed loop
+inline void pauseTiming(benchmark::State& state, PerfCounters& perf_)
+{
+    perf_.stop();
+    pauseAllocationCounting();
+    state.PauseTiming();
+}
+
+inline void resumeTiming(benchmark::State& state, PerfCounters& perf_)
+{
+    state.ResumeTiming();
+    resumeAllocationCounting();
+    perf_.start();
+}
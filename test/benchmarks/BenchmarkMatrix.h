@@ -0,0 +1,336 @@
+
+#pragma once
+
+// Parameterized single-threaded benchmark matrix:
+//      operation x engine x element count x value payload
+//
+// Every operation (insert.cpp, erase.cpp, iterate.cpp, construct.cpp, footprint.cpp)
+// defines a struct with a static run<Map, T>(benchmark::State&) and registers it
+// for the whole matrix via registerMatrix<Op>(). An operation that only applies
+// to some engines also defines a supports<Map> flag, the others are skipped.
+// The element count is the benchmark's argument, so a run can be narrowed down
+// with e.g. --benchmark_filter=insert_bytes64_.*/10000
+
+#include "locked_slot_map.h"
+#include "optimized_locked_slot_map.h"
+#include "lock_free_const_sized_slot_map.h"
+#include "dynamic_slot_map.h"
+
+#include "slot_map.h"
+
+#include "../BaselineMaps.h"
+#include "../Payload.h"
+#include "BenchmarkHelpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename T> constexpr const char* payloadName();
+template<> constexpr const char* payloadName<int64_t>()       { return "int64"; }
+template<> constexpr const char* payloadName<Payload<64>>()   { return "bytes64"; }
+template<> constexpr const char* payloadName<Payload<256>>()  { return "bytes256"; }
+template<> constexpr const char* payloadName<Payload<4096>>() { return "bytes4096"; }
+template<> constexpr const char* payloadName<std::string>()   { return "string"; }
+
+// generated once per benchmark, before the timed loop
+template<typename T>
+std::vector<T> makeValues(const size_t count_)
+{
+    std::vector<T> values;
+    values.reserve(count_);
+    for (size_t i = 0; i < count_; ++i)
+        values.push_back(makeValue<T>(i));
+    return values;
+}
+
+template<typename T>
+size_t valueBytes(const T& val_)
+{
+    if constexpr (std::is_same_v<T, std::string>)
+        return val_.size();
+    else
+        return sizeof(T);
+}
+
+
+// std::vector exposed through the slot map interface, as the lower bound the
+// slot maps are compared against. Keys are plain indices, and erase swaps the
+// erased element with the last one - so the keys of the other elements are only
+// stable if erasing in reverse order of insertion.
+template<typename T>
+class VectorBaseline
+{
+public:
+    using key_type   = size_t;
+    using value_type = T;
+
+    key_type insert(const T& value)
+    {
+        _data.push_back(value);
+        return _data.size() - 1;
+    }
+
+    void erase(const key_type& key)
+    {
+        if (key != _data.size() - 1)
+            _data[key] = std::move(_data.back());
+        _data.pop_back();
+    }
+
+    // no generations, so a key to a replaced element still finds the new one
+    std::optional<std::reference_wrapper<T>> find(const key_type& key)
+    {
+        if (key >= _data.size())
+            return {};
+        return _data[key];
+    }
+
+    T& find_unchecked(const key_type& key) { return _data[key]; }
+    T& at(const key_type& key)             { return _data.at(key); }
+    T& operator[](const key_type& key)     { return _data[key]; }
+
+    template <class P>
+    void iterate_map(P pred)
+    {
+        for (auto& val : _data)
+            pred(val);
+    }
+
+    void reserve(size_t n) { _data.reserve(n); }
+    size_t size() const { return _data.size(); }
+
+private:
+    std::vector<T> _data;
+};
+
+template<typename Map, typename T>
+std::vector<typename Map::key_type> insertValues(Map& map_, const std::vector<T>& values_)
+{
+    std::vector<typename Map::key_type> keys;
+    keys.reserve(values_.size());
+    for (const auto& val : values_)
+        keys.push_back(map_.insert(val));
+    return keys;
+}
+
+template<typename Map, typename Fnc>
+void iterateValues(Map& map_, Fnc fnc_)
+{
+    if constexpr (requires { map_.iterate_map(fnc_); })
+        map_.iterate_map(fnc_);
+    else
+        for (auto& val : map_)
+            fnc_(val);
+}
+
+// items/bytes per second, plus the average time a single element took
+template<typename T>
+void setMatrixCounters(benchmark::State& state, const std::vector<T>& values_, const PerfCounters& perf_,
+                       const AllocationCounter& allocations_)
+{
+    setPerfCounters(state, perf_, static_cast<double>(values_.size()));
+    setAllocationCounters(state, allocations_, static_cast<double>(values_.size()));
+
+    size_t bytes {};
+    for (const auto& val : values_)
+        bytes += valueBytes(val);
+
+    state.SetItemsProcessed(state.iterations() * values_.size());
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.counters["time_per_item"] = benchmark::Counter(static_cast<double>(values_.size()),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+
+// engines - map_type takes the element count so that the fixed sized maps
+// can be sized to exactly the amount of elements benchmarked
+struct VectorEngine
+{
+    static constexpr const char* name = "vector";
+    static constexpr bool fixed_size = false;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = VectorBaseline<T>;
+};
+
+struct SG14SlotMapEngine
+{
+    static constexpr const char* name = "sg14SlotMap";
+    static constexpr bool fixed_size = false;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = stdext::slot_map<T>;
+};
+
+struct LockedSlotMapEngine
+{
+    static constexpr const char* name = "lockedSlotMap";
+    static constexpr bool fixed_size = false;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = gby::locked_slot_map<T>;
+};
+
+struct OptimizedLockedSlotMapEngine
+{
+    static constexpr const char* name = "optimizedLockedSlotMap";
+    static constexpr bool fixed_size = true;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = gby::optimized_locked_slot_map<T, Count>;
+};
+
+struct LockFreeConstSizedSlotMapEngine
+{
+    static constexpr const char* name = "lockFreeConstSizedSlotMap";
+    static constexpr bool fixed_size = true;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = gby::lock_free_const_sized_slot_map<T, Count>;
+};
+
+struct DynamicSlotMapEngine
+{
+    static constexpr const char* name = "dynamicSlotMap";
+    static constexpr bool fixed_size = false;
+    // bounded by the max capacity of its internal_vector
+    static constexpr size_t max_elements = 100000;
+    template<typename T, size_t Count> using map_type = gby::dynamic_slot_map<T>;
+};
+
+struct SpinlockSlotMapEngine
+{
+    static constexpr const char* name = "sg14SlotMapSpinlock";
+    static constexpr bool fixed_size = false;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = SpinlockSlotMap<T>;
+};
+
+struct ShardedUnorderedMapEngine
+{
+    static constexpr const char* name = "shardedUnorderedMap";
+    static constexpr bool fixed_size = false;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = ShardedUnorderedMap<T>;
+};
+
+struct OpenAddressingHashMapEngine
+{
+    static constexpr const char* name = "openAddressingHashMap";
+    static constexpr bool fixed_size = false;
+    static constexpr size_t max_elements = SIZE_MAX;
+    template<typename T, size_t Count> using map_type = OpenAddressingHashMap<T>;
+};
+
+
+constexpr std::array<size_t, 6> matrixCounts {1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+// rough upper bound of the bookkeeping (slots, reverse/erase arrays, key vector)
+// every engine keeps per element, on top of the element itself
+constexpr size_t matrixPerElementOverhead {64};
+
+// The large counts don't fit in memory for the wide payloads, so only the
+// counts whose estimated footprint (the map plus the generated values) fits
+// in half of the physical memory are registered.
+template<typename T>
+bool fitsInMemory(const size_t count_)
+{
+    static const size_t memoryLimit = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) *
+                                      static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 2;
+    return count_ * (2*sizeof(T) + matrixPerElementOverhead) <= memoryLimit;
+}
+
+template<typename Engine, typename T>
+bool isMatrixCount(const size_t count_)
+{
+    return count_ <= Engine::max_elements && fitsInMemory<T>(count_);
+}
+
+template<typename Op, typename Engine, typename T>
+std::string matrixBenchmarkName()
+{
+    return std::string{Op::name} + "_" + payloadName<T>() + "_" + Engine::name;
+}
+
+// an operation can leave out maps it doesn't apply to, by defining
+// template<typename Map> static constexpr bool supports
+template<typename Op, typename Map>
+constexpr bool opSupports()
+{
+    if constexpr (requires { Op::template supports<Map>; })
+        return Op::template supports<Map>;
+    else
+        return true;
+}
+
+// the fixed sized maps take their size as a template parameter, so every count is its own instantiation
+template<typename Op, typename Engine, typename T, size_t Count>
+void registerFixedSizedCount()
+{
+    if constexpr (!opSupports<Op, typename Engine::template map_type<T, Count>>())
+        return;
+
+    if (!isMatrixCount<Engine, T>(Count))
+        return;
+
+    benchmark::RegisterBenchmark(matrixBenchmarkName<Op, Engine, T>().c_str(),
+                                 Op::template run<typename Engine::template map_type<T, Count>, T>)
+        ->Arg(Count);
+}
+
+template<typename Op, typename Engine, typename T, size_t... Idx>
+void registerFixedSized(std::index_sequence<Idx...>)
+{
+    (registerFixedSizedCount<Op, Engine, T, matrixCounts[Idx]>(), ...);
+}
+
+template<typename Op, typename Engine, typename T>
+void registerEngine()
+{
+    if constexpr (Engine::fixed_size)
+    {
+        registerFixedSized<Op, Engine, T>(std::make_index_sequence<matrixCounts.size()>{});
+    }
+    else if constexpr (opSupports<Op, typename Engine::template map_type<T, 0>>())
+    {
+        size_t maxCount = matrixCounts.front();
+        for (size_t count : matrixCounts)
+            if (isMatrixCount<Engine, T>(count))
+                maxCount = count;
+
+        benchmark::RegisterBenchmark(matrixBenchmarkName<Op, Engine, T>().c_str(),
+                                     Op::template run<typename Engine::template map_type<T, 0>, T>)
+            ->RangeMultiplier(10)
+            ->Range(matrixCounts.front(), maxCount);
+    }
+}
+
+template<typename Op, typename T>
+void registerPayload()
+{
+    registerEngine<Op, VectorEngine, T>();
+    registerEngine<Op, SG14SlotMapEngine, T>();
+    registerEngine<Op, LockedSlotMapEngine, T>();
+    registerEngine<Op, OptimizedLockedSlotMapEngine, T>();
+    registerEngine<Op, LockFreeConstSizedSlotMapEngine, T>();
+    registerEngine<Op, DynamicSlotMapEngine, T>();
+    registerEngine<Op, SpinlockSlotMapEngine, T>();
+    registerEngine<Op, ShardedUnorderedMapEngine, T>();
+    registerEngine<Op, OpenAddressingHashMapEngine, T>();
+}
+
+template<typename Op>
+bool registerMatrix()
+{
+    registerPayload<Op, int64_t>();
+    registerPayload<Op, Payload<64>>();
+    registerPayload<Op, Payload<256>>();
+    registerPayload<Op, Payload<4096>>();
+    registerPayload<Op, std::string>();
+    return true;
+}
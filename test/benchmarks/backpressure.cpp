@@ -0,0 +1,144 @@
+
+#include "optimized_locked_slot_map.h"
+#include "lock_free_const_sized_slot_map.h"
+#include "backoff.h"
+
+#include "BenchmarkHelpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Bounded producer/consumer: even threads insert into a small fixed sized map
+// and hand the keys over to their paired (odd) thread, which erases them. The
+// map is smaller than the hand-over ring, so producers are throttled by the map
+// being full - which is what the different insert policies handle differently.
+
+constexpr size_t mapCapacity {1024};
+constexpr size_t ringCapacity {2*mapCapacity};
+
+enum class InsertPolicy
+{
+    CatchAndRetry,
+    InsertWait,
+    TryInsertFor
+};
+
+// single producer single consumer ring used to hand keys to the consumer
+template<typename Key>
+class KeyRing
+{
+public:
+    KeyRing() : _keys(ringCapacity) {}
+
+    void push(const Key& key_)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        gby::backoff bo;
+        while (tail - _head.load(std::memory_order_acquire) == ringCapacity)
+            bo.pause();
+
+        _keys[tail % ringCapacity] = key_;
+        _tail.store(tail+1, std::memory_order_release);
+    }
+
+    Key pop()
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        gby::backoff bo;
+        while (_tail.load(std::memory_order_acquire) == head)
+            bo.pause();
+
+        Key key = _keys[head % ringCapacity];
+        _head.store(head+1, std::memory_order_release);
+        return key;
+    }
+
+private:
+    std::vector<Key> _keys;
+    alignas(64) std::atomic<size_t> _head {};
+    alignas(64) std::atomic<size_t> _tail {};
+};
+
+template<typename Map>
+std::vector<std::unique_ptr<KeyRing<typename Map::key_type>>> keyRings {};
+
+template<InsertPolicy Policy, typename Map>
+typename Map::key_type produce(Map& map_, const int64_t val_)
+{
+    using namespace std::chrono_literals;
+
+    if constexpr (Policy == InsertPolicy::InsertWait)
+    {
+        return map_.insert_wait(val_);
+    }
+    else if constexpr (Policy == InsertPolicy::TryInsertFor)
+    {
+        auto key = map_.try_insert_for(val_, 1ms);
+        while (!key)
+            key = map_.try_insert_for(val_, 1ms);
+        return *key;
+    }
+    else
+    {
+        while (true)
+        {
+            try
+            {
+                return map_.insert(val_);
+            }
+            catch(const std::length_error&)
+            {
+                // without draining ourselves we could spin forever on
+                // erased elements whose drain was skipped
+                flushEraseQueue(map_);
+            }
+        }
+    }
+}
+
+template<typename Map, InsertPolicy Policy>
+static void backpressure_int64(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+    {
+        sharedMap<Map> = std::make_unique<Map>();
+        keyRings<Map>.clear();
+        for (int i = 0; i < state.threads()/2; ++i)
+            keyRings<Map>.push_back(std::make_unique<KeyRing<typename Map::key_type>>());
+    }
+
+    const bool   isProducer = state.thread_index() % 2 == 0;
+    const size_t pairIdx    = state.thread_index() / 2;
+    int64_t val = state.thread_index();
+    for (auto _ : state)
+    {
+        auto& ring = *keyRings<Map>[pairIdx];
+        if (isProducer)
+            ring.push(produce<Policy>(*sharedMap<Map>, val));
+        else
+            sharedMap<Map>->erase(ring.pop());
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0)
+    {
+        keyRings<Map>.clear();
+        sharedMap<Map>.reset();
+    }
+}
+
+using OptimizedMap = gby::optimized_locked_slot_map<int64_t, mapCapacity>;
+using LockFreeMap  = gby::lock_free_const_sized_slot_map<int64_t, mapCapacity>;
+
+BENCHMARK_TEMPLATE(backpressure_int64, OptimizedMap, InsertPolicy::CatchAndRetry)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK_TEMPLATE(backpressure_int64, OptimizedMap, InsertPolicy::InsertWait)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK_TEMPLATE(backpressure_int64, OptimizedMap, InsertPolicy::TryInsertFor)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+BENCHMARK_TEMPLATE(backpressure_int64, LockFreeMap, InsertPolicy::CatchAndRetry)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK_TEMPLATE(backpressure_int64, LockFreeMap, InsertPolicy::InsertWait)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK_TEMPLATE(backpressure_int64, LockFreeMap, InsertPolicy::TryInsertFor)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
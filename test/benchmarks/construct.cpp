@@ -0,0 +1,76 @@
+
+#include "BenchmarkMatrix.h"
+
+#include <benchmark/benchmark.h>
+
+// Constructing and destroying an empty map, sized for the element count - the
+// startup (and shutdown) cost of the engine. The fixed sized maps allocate and
+// initialize all their arrays and link their whole free list up front, the
+// others only reserve.
+
+void setConstructionCounters(benchmark::State& state, const size_t count_, const PerfCounters& perf_,
+                             const AllocationCounter& allocations_)
+{
+    setPerfCounters(state, perf_, static_cast<double>(count_));
+    setAllocationCounters(state, allocations_, static_cast<double>(count_));
+    state.SetItemsProcessed(state.iterations() * count_);
+    state.counters["time_per_item"] = benchmark::Counter(static_cast<double>(count_),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// Only the construction is timed, destroying the map is not.
+struct ConstructOp
+{
+    static constexpr const char* name = "construct";
+
+    template<typename Map, typename T>
+    static void run(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+
+        PerfCounters perf;
+        AllocationCounter allocations;
+        perf.start();
+        for (auto _ : state)
+        {
+            auto map = makeMap<Map>(count);
+            benchmark::DoNotOptimize(map.get());
+
+            pauseTiming(state, perf);
+            map.reset();
+            resumeTiming(state, perf);
+        }
+        perf.stop();
+        setConstructionCounters(state, count, perf, allocations);
+    }
+};
+
+// Only the destruction is timed, of a map that was never inserted into.
+struct DestroyOp
+{
+    static constexpr const char* name = "destroy";
+
+    template<typename Map, typename T>
+    static void run(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+
+        PerfCounters perf;
+        AllocationCounter allocations;
+        perf.start();
+        for (auto _ : state)
+        {
+            pauseTiming(state, perf);
+            auto map = makeMap<Map>(count);
+            benchmark::DoNotOptimize(map.get());
+            resumeTiming(state, perf);
+
+            map.reset();
+        }
+        perf.stop();
+        setConstructionCounters(state, count, perf, allocations);
+    }
+};
+
+static const bool constructBenchmarksRegistered = registerMatrix<ConstructOp>();
+static const bool destroyBenchmarksRegistered   = registerMatrix<DestroyOp>();
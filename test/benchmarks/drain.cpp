@@ -0,0 +1,203 @@
+
+#include "optimized_locked_slot_map.h"
+#include "dynamic_slot_map.h"
+#include "latency_histogram.h"
+
+#include "BenchmarkHelpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Draining the erase queue holds _eraseMut exclusively, stalling every insert
+// and iterate_map meanwhile. These benchmarks queue a backlog of erases (the
+// benchmark argument) and then drain it:
+//  - drain_int64:      the drain alone, single threaded
+//  - drainStall_int64: with an inserter and an iterator running concurrently,
+//                      reporting how long their inserts take and how long
+//                      iterate_map waits before it gets to the first element
+
+constexpr size_t drainElementCount {1 << 16};
+
+using OptimizedMap = gby::optimized_locked_slot_map<int64_t, 2*drainElementCount>;
+using DynamicMap   = gby::dynamic_slot_map<int64_t>;
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nanosSince(const Clock::time_point start_)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count();
+}
+
+void setLatencyCounters(benchmark::State& state, const std::string& op_, const gby::latency_histogram& latencies_)
+{
+    state.counters[op_ + "_p50_ns"]   = static_cast<double>(latencies_.percentile(50));
+    state.counters[op_ + "_p99_ns"]   = static_cast<double>(latencies_.percentile(99));
+    state.counters[op_ + "_p99.9_ns"] = static_cast<double>(latencies_.percentile(99.9));
+    state.counters[op_ + "_max_ns"]   = static_cast<double>(latencies_.max());
+}
+
+// the map, filled with drainElementCount elements, and the keys the backlogs
+// are made of - every queueBacklog erases the oldest keys and refill reinserts them
+template<typename Map>
+class DrainFixture
+{
+public:
+    DrainFixture()
+    {
+        _keys.reserve(drainElementCount);
+        for (size_t i = 0; i < drainElementCount; ++i)
+            _keys.push_back(map->insert(static_cast<int64_t>(i)));
+    }
+
+    // erases without draining, by queueing the erases directly
+    void queueBacklog(const size_t backlog_)
+    {
+        for (size_t i = 0; i < backlog_; ++i)
+            map->addToEraseQueue(_keys[(_next + i) % _keys.size()]);
+    }
+
+    void refill(const size_t backlog_)
+    {
+        for (size_t i = 0; i < backlog_; ++i, ++_next)
+            _keys[_next % _keys.size()] = map->insert(static_cast<int64_t>(_next));
+    }
+
+    // a dynamic_slot_map grows for the elements of the concurrent inserter
+    std::unique_ptr<Map> map {makeMap<Map>(drainElementCount)};
+
+private:
+    std::vector<typename Map::key_type> _keys;
+    size_t _next {};
+};
+
+template<typename Map>
+static void drain_int64(benchmark::State& state)
+{
+    const auto backlog = static_cast<size_t>(state.range(0));
+    DrainFixture<Map> fixture;
+
+    PerfCounters perf;
+
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        pauseTiming(state, perf);
+        fixture.queueBacklog(backlog);
+        resumeTiming(state, perf);
+
+        fixture.map->template drainEraseQueue<true>();
+
+        pauseTiming(state, perf);
+        fixture.refill(backlog);
+        resumeTiming(state, perf);
+    }
+    perf.stop();
+    setPerfCounters(state, perf, static_cast<double>(backlog));
+    setAllocationCounters(state, allocations, static_cast<double>(backlog));
+    state.SetItemsProcessed(state.iterations() * backlog);
+    state.counters["time_per_erase"] = benchmark::Counter(static_cast<double>(backlog),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// every iteration queues the backlog, drains it and refills the map, while the
+// inserter inserts (and erases right after) and the iterator iterates nonstop.
+// Their own (non-blocking) drains may beat this one to the backlog - in which
+// case they are the ones stalled by it, as would happen in production.
+template<typename Map>
+static void drainStall_int64(benchmark::State& state)
+{
+    const auto backlog = static_cast<size_t>(state.range(0));
+    DrainFixture<Map> fixture;
+    auto& map = *fixture.map;
+
+    std::atomic<bool> stop {false};
+    gby::latency_histogram insertLatencies {};
+    gby::latency_histogram iterateWaits {};
+    gby::latency_histogram drainLatencies {};
+
+    std::thread inserter {[&]
+    {
+        for (int64_t val = 0; !stop.load(std::memory_order_relaxed); ++val)
+        {
+            // the iterator rarely lets go of _eraseMut, so this thread's own drains
+            // mostly fail - a full map is drained blocking, and that stall timed too
+            const auto start = Clock::now();
+            std::optional<typename Map::key_type> key;
+            while (!key && !stop.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    key = map.insert(val);
+                }
+                catch (const std::length_error&)
+                {
+                    map.template drainEraseQueue<true>();
+                }
+            }
+            if (!key)
+                break;
+
+            insertLatencies.record(nanosSince(start));
+            map.erase(*key);
+        }
+    }};
+
+    std::thread iterator {[&]
+    {
+        int64_t sum {};
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            bool first = true;
+            const auto start = Clock::now();
+            map.iterate_map([&](const int64_t& val)
+            {
+                if (first)
+                {
+                    iterateWaits.record(nanosSince(start));
+                    first = false;
+                }
+                sum += val;
+            });
+        }
+        benchmark::DoNotOptimize(sum);
+    }};
+
+    for (auto _ : state)
+    {
+        fixture.queueBacklog(backlog);
+
+        const auto start = Clock::now();
+        map.template drainEraseQueue<true>();
+        drainLatencies.record(nanosSince(start));
+
+        fixture.refill(backlog);
+    }
+
+    stop.store(true, std::memory_order_relaxed);
+    inserter.join();
+    iterator.join();
+
+    setLatencyCounters(state, "drain", drainLatencies);
+    setLatencyCounters(state, "insert", insertLatencies);
+    setLatencyCounters(state, "iterate_wait", iterateWaits);
+}
+
+void drainBacklogs(benchmark::internal::Benchmark* bench_)
+{
+    for (int64_t backlog : {1, 16, 256, 4096, static_cast<int>(drainElementCount/2)})
+        bench_->Arg(backlog);
+}
+
+BENCHMARK_TEMPLATE(drain_int64, OptimizedMap)->Apply(drainBacklogs);
+BENCHMARK_TEMPLATE(drain_int64, DynamicMap)->Apply(drainBacklogs);
+
+BENCHMARK_TEMPLATE(drainStall_int64, OptimizedMap)->Apply(drainBacklogs)->UseRealTime();
+BENCHMARK_TEMPLATE(drainStall_int64, DynamicMap)->Apply(drainBacklogs)->UseRealTime();
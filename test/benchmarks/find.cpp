@@ -0,0 +1,301 @@
+
+#include "BenchmarkMatrix.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Single-threaded lookups (find, find_unchecked, at and operator[]) into a full
+// map, for several key access patterns. VectorBaseline is the plain vector index
+// the slot indirection is measured against.
+
+constexpr size_t lookupElementCount {1 << 16};
+
+// every iteration looks up a batch of keys out of a pre-generated key stream
+constexpr size_t lookupBatchSize {1024};
+constexpr size_t lookupStreamLength {1 << 16};
+
+// evicting takes far longer than the batch it precedes, and isn't timed, so the
+// cold pattern runs a fixed amount of iterations rather than a minimum time
+constexpr benchmark::IterationCount coldIterations {256};
+
+// skew of the Zipfian pattern, the same as YCSB's default
+constexpr double zipfianSkew {0.99};
+
+enum class Lookup
+{
+    Find,
+    FindUnchecked,
+    At,
+    Subscript
+};
+
+enum class KeyPattern
+{
+    Sequential,     // keys in insertion order
+    Uniform,        // uniformly random keys
+    Zipfian,        // a few hot keys, scattered over the map
+    Stale,          // keys of erased elements whose slots were since reused
+    Cold            // uniformly random keys, with the LLC evicted between batches
+};
+
+constexpr const char* lookupName(const Lookup lookup_)
+{
+    switch (lookup_)
+    {
+        case Lookup::Find:          return "find";
+        case Lookup::FindUnchecked: return "findUnchecked";
+        case Lookup::At:            return "at";
+        case Lookup::Subscript:     return "subscript";
+    }
+    return "";
+}
+
+constexpr const char* keyPatternName(const KeyPattern pattern_)
+{
+    switch (pattern_)
+    {
+        case KeyPattern::Sequential: return "sequential";
+        case KeyPattern::Uniform:    return "uniform";
+        case KeyPattern::Zipfian:    return "zipfian";
+        case KeyPattern::Stale:      return "stale";
+        case KeyPattern::Cold:       return "cold";
+    }
+    return "";
+}
+
+// value of the element found, 0 on a miss
+template<Lookup Method, typename Map>
+int64_t lookup(Map& map_, const typename Map::key_type& key_)
+{
+    if constexpr (Method == Lookup::Find)
+    {
+        if constexpr (requires { map_.find(key_).has_value(); })
+        {
+            auto val = map_.find(key_);
+            return val ? val->get() : 0;
+        }
+        else
+        {
+            auto it = map_.find(key_);
+            return it != map_.end() ? *it : 0;
+        }
+    }
+    else if constexpr (Method == Lookup::FindUnchecked)
+    {
+        if constexpr (requires { *map_.find_unchecked(key_); })
+            return *map_.find_unchecked(key_);
+        else
+            return map_.find_unchecked(key_);
+    }
+    else if constexpr (Method == Lookup::At)
+    {
+        // the gby maps return an empty optional on a miss, the others throw
+        if constexpr (requires { map_.at(key_).has_value(); })
+        {
+            auto val = map_.at(key_);
+            return val ? val->get() : 0;
+        }
+        else
+        {
+            try
+            {
+                return map_.at(key_);
+            }
+            catch (const std::out_of_range&)
+            {
+                return 0;
+            }
+        }
+    }
+    else
+    {
+        return map_[key_];
+    }
+}
+
+// indices into the map's keys, drawn from a Zipfian distribution. The ranks are
+// shuffled so that the hot keys are spread over the map rather than adjacent.
+std::vector<size_t> zipfianIndices(std::mt19937_64& randomEngine_)
+{
+    std::vector<double> cdf (lookupElementCount);
+    double sum {};
+    for (size_t rank = 0; rank < lookupElementCount; ++rank)
+        cdf[rank] = (sum += 1.0 / std::pow(static_cast<double>(rank+1), zipfianSkew));
+
+    std::vector<size_t> rankToIdx (lookupElementCount);
+    std::iota(rankToIdx.begin(), rankToIdx.end(), 0);
+    std::shuffle(rankToIdx.begin(), rankToIdx.end(), randomEngine_);
+
+    std::uniform_real_distribution<double> dist {0, sum};
+    std::vector<size_t> indices (lookupStreamLength);
+    for (auto& idx : indices)
+    {
+        const size_t rank = std::lower_bound(cdf.begin(), cdf.end(), dist(randomEngine_)) - cdf.begin();
+        idx = rankToIdx[std::min(rank, lookupElementCount-1)];
+    }
+    return indices;
+}
+
+std::vector<size_t> keyIndices(const KeyPattern pattern_)
+{
+    std::mt19937_64 randomEngine {42};
+    if (pattern_ == KeyPattern::Zipfian)
+        return zipfianIndices(randomEngine);
+
+    std::vector<size_t> indices (lookupStreamLength);
+    if (pattern_ == KeyPattern::Sequential)
+    {
+        for (size_t i = 0; i < lookupStreamLength; ++i)
+            indices[i] = i % lookupElementCount;
+    }
+    else
+    {
+        std::uniform_int_distribution<size_t> dist {0, lookupElementCount-1};
+        for (auto& idx : indices)
+            idx = dist(randomEngine);
+    }
+    return indices;
+}
+
+// writes over a buffer twice the size of the largest cache, pushing the map out of it
+void evictLastLevelCache()
+{
+    static std::vector<char> evictionBuffer = []
+    {
+        size_t llcSize {32 << 20};
+        for (const auto& cache : benchmark::CPUInfo::Get().caches)
+            llcSize = std::max(llcSize, static_cast<size_t>(cache.size));
+        return std::vector<char>(2*llcSize);
+    }();
+
+    for (size_t i = 0; i < evictionBuffer.size(); i += 64)
+        ++evictionBuffer[i];
+    benchmark::ClobberMemory();
+}
+
+template<typename Map, Lookup Method, KeyPattern Pattern>
+static void find_int64(benchmark::State& state)
+{
+    auto map  = makeMap<Map>(lookupElementCount);
+    auto keys = insertValues(*map, makeValues<int64_t>(lookupElementCount));
+
+    if constexpr (Pattern == KeyPattern::Stale)
+    {
+        // reinserting into the erased slots bumps their generation, so the
+        // old keys point at live slots but no longer match them
+        for (auto& key : keys)
+            map->erase(key);
+        flushEraseQueue(*map);
+        insertValues(*map, makeValues<int64_t>(lookupElementCount));
+    }
+
+    std::vector<typename Map::key_type> stream;
+    stream.reserve(lookupStreamLength);
+    for (size_t idx : keyIndices(Pattern == KeyPattern::Cold ? KeyPattern::Uniform : Pattern))
+        stream.push_back(keys[idx]);
+
+    PerfCounters perf;
+
+    AllocationCounter allocations;
+    size_t streamIdx {};
+    perf.start();
+    for (auto _ : state)
+    {
+        if constexpr (Pattern == KeyPattern::Cold)
+        {
+            pauseTiming(state, perf);
+            evictLastLevelCache();
+            resumeTiming(state, perf);
+        }
+
+        int64_t sum {};
+        for (size_t i = 0; i < lookupBatchSize; ++i)
+            sum += lookup<Method>(*map, stream[streamIdx++ % lookupStreamLength]);
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    setPerfCounters(state, perf, lookupBatchSize);
+    setAllocationCounters(state, allocations, lookupBatchSize);
+    state.SetItemsProcessed(state.iterations() * lookupBatchSize);
+    state.counters["time_per_lookup"] = benchmark::Counter(static_cast<double>(lookupBatchSize),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+
+// the baseline maps only implement find
+template<typename Map, Lookup Method>
+constexpr bool hasLookup()
+{
+    using key_type = typename Map::key_type;
+    if constexpr (Method == Lookup::Find)
+        return true;
+    else if constexpr (Method == Lookup::FindUnchecked)
+        return requires (Map& map_, const key_type& key_) { map_.find_unchecked(key_); };
+    else if constexpr (Method == Lookup::At)
+        return requires (Map& map_, const key_type& key_) { map_.at(key_); };
+    else
+        return requires (Map& map_, const key_type& key_) { map_[key_]; };
+}
+
+template<typename Engine, Lookup Method, KeyPattern Pattern>
+void registerFindBenchmark()
+{
+    // find_unchecked and operator[] are undefined for stale keys, and
+    // the vector has no generations to tell a stale key apart with
+    if constexpr (Pattern == KeyPattern::Stale)
+    {
+        if constexpr (Method == Lookup::FindUnchecked || Method == Lookup::Subscript ||
+                      std::is_same_v<Engine, VectorEngine>)
+            return;
+    }
+
+    using Map = typename Engine::template map_type<int64_t, lookupElementCount>;
+    if constexpr (hasLookup<Map, Method>())
+    {
+        const std::string name = std::string{"find_int64_"} + lookupName(Method) + "_" +
+                                 keyPatternName(Pattern) + "_" + Engine::name;
+        auto* bench = benchmark::RegisterBenchmark(name.c_str(), find_int64<Map, Method, Pattern>);
+        if constexpr (Pattern == KeyPattern::Cold)
+            bench->Iterations(coldIterations);
+    }
+}
+
+template<typename Engine, Lookup Method>
+void registerFindPatterns()
+{
+    registerFindBenchmark<Engine, Method, KeyPattern::Sequential>();
+    registerFindBenchmark<Engine, Method, KeyPattern::Uniform>();
+    registerFindBenchmark<Engine, Method, KeyPattern::Zipfian>();
+    registerFindBenchmark<Engine, Method, KeyPattern::Stale>();
+    registerFindBenchmark<Engine, Method, KeyPattern::Cold>();
+}
+
+template<typename Engine>
+void registerFindEngine()
+{
+    registerFindPatterns<Engine, Lookup::Find>();
+    registerFindPatterns<Engine, Lookup::FindUnchecked>();
+    registerFindPatterns<Engine, Lookup::At>();
+    registerFindPatterns<Engine, Lookup::Subscript>();
+}
+
+static const bool findBenchmarksRegistered = []
+{
+    registerFindEngine<VectorEngine>();
+    registerFindEngine<SG14SlotMapEngine>();
+    registerFindEngine<LockedSlotMapEngine>();
+    registerFindEngine<OptimizedLockedSlotMapEngine>();
+    registerFindEngine<LockFreeConstSizedSlotMapEngine>();
+    registerFindEngine<DynamicSlotMapEngine>();
+    registerFindEngine<SpinlockSlotMapEngine>();
+    registerFindEngine<ShardedUnorderedMapEngine>();
+    registerFindEngine<OpenAddressingHashMapEngine>();
+    return true;
+}();
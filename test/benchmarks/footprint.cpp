@@ -0,0 +1,98 @@
+
+#include "BenchmarkMatrix.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// Heap bytes per live element, per component, from the maps' memory_usage():
+//  - footprint:      a map reserved for and filled with the element count
+//  - footprintChurn: the same map after rounds of erasing a random half of
+//                    the elements and reinserting them, left half full
+// Nothing is timed - the counters are the result, the timed loop is empty.
+
+constexpr size_t footprintChurnRounds {4};
+
+template<typename Map>
+void setFootprintCounters(benchmark::State& state, const Map& map_, const size_t liveElements_)
+{
+    const auto usage = map_.memory_usage();
+    const auto perElement = [&](const size_t bytes_) { return static_cast<double>(bytes_) / liveElements_; };
+
+    state.counters["slots_bytes_per_element"]         = perElement(usage.slots);
+    state.counters["data_bytes_per_element"]          = perElement(usage.data);
+    state.counters["reverse_array_bytes_per_element"] = perElement(usage.reverse_array);
+    state.counters["erase_queue_bytes_per_element"]   = perElement(usage.erase_queue);
+    state.counters["bucket_slack_bytes_per_element"]  = perElement(usage.bucket_slack);
+    state.counters["total_bytes_per_element"]         = perElement(usage.total());
+    state.counters["total_bytes"]                     = static_cast<double>(usage.total());
+}
+
+template<typename Map>
+constexpr bool hasMemoryUsage = requires (const Map& map_) { map_.memory_usage(); };
+
+struct FootprintOp
+{
+    static constexpr const char* name = "footprint";
+
+    template<typename Map>
+    static constexpr bool supports = hasMemoryUsage<Map>;
+
+    template<typename Map, typename T>
+    static void run(benchmark::State& state)
+    {
+        const auto values = makeValues<T>(state.range(0));
+        auto map = makeMap<Map>(values.size());
+        insertValues(*map, values);
+
+        for (auto _ : state) {}
+        setFootprintCounters(state, *map, values.size());
+    }
+};
+
+struct FootprintChurnOp
+{
+    static constexpr const char* name = "footprintChurn";
+
+    template<typename Map>
+    static constexpr bool supports = hasMemoryUsage<Map>;
+
+    template<typename Map, typename T>
+    static void run(benchmark::State& state)
+    {
+        const auto values = makeValues<T>(state.range(0));
+        auto map  = makeMap<Map>(values.size());
+        auto keys = insertValues(*map, values);
+
+        std::vector<size_t> order (keys.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+
+        std::mt19937_64 randomEngine {42};
+        const size_t half = keys.size() / 2;
+        const auto eraseHalf = [&]
+        {
+            std::shuffle(order.begin(), order.end(), randomEngine);
+            for (size_t i = 0; i < half; ++i)
+                map->erase(keys[order[i]]);
+            flushEraseQueue(*map);
+        };
+
+        for (size_t round = 0; round < footprintChurnRounds; ++round)
+        {
+            eraseHalf();
+            for (size_t i = 0; i < half; ++i)
+                keys[order[i]] = map->insert(values[order[i]]);
+        }
+        eraseHalf();
+
+        for (auto _ : state) {}
+        setFootprintCounters(state, *map, keys.size() - half);
+    }
+};
+
+static const bool footprintBenchmarksRegistered      = registerMatrix<FootprintOp>();
+static const bool footprintChurnBenchmarksRegistered = registerMatrix<FootprintChurnOp>();
@@ -0,0 +1,101 @@
+
+#include "optimized_locked_slot_map.h"
+#include "lock_free_const_sized_slot_map.h"
+#include "dynamic_slot_map.h"
+
+#include "BenchmarkHelpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+// These benchmarks purposely run with more threads than there are cores, so
+// that threads spinning on the free list (or waiting on a growing map) compete
+// for cpu time with the threads they are waiting on.
+
+// keeps the dynamic slot map below the max capacity of its internal_vector
+constexpr size_t growthInsertCount {30000};
+
+// amount of elements every thread inserts (and then erases) per iteration
+constexpr size_t churnBatchSize {64};
+
+
+static void oversubscribed_int64_dynamicSlotMap_growth(benchmark::State& state)
+{
+    using Map = gby::dynamic_slot_map<int64_t>;
+
+    if (state.thread_index() == 0)
+        sharedMap<Map> = std::make_unique<Map>(1);
+
+    int64_t val = state.thread_index();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(sharedMap<Map>->insert(val));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0)
+        sharedMap<Map>.reset();
+}
+
+
+template<typename Map>
+static void oversubscribed_int64_churn(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        sharedMap<Map> = std::make_unique<Map>();
+
+    std::vector<typename Map::key_type> keys;
+    keys.reserve(churnBatchSize);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < churnBatchSize; ++i)
+            keys.push_back(sharedMap<Map>->insert(static_cast<int64_t>(i)));
+
+        for (auto& key : keys)
+            sharedMap<Map>->erase(key);
+
+        // keeps the erase backlog bounded, otherwise a thread preempted 
+        // mid-drain lets the others fill up the (fixed sized) map.
+        flushEraseQueue(*sharedMap<Map>);
+        keys.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * churnBatchSize * 2);
+
+    if (state.thread_index() == 0)
+        sharedMap<Map>.reset();
+}
+
+
+static void registerOversubscribedBenchmarks()
+{
+    for (int threadMultiplier : {1, 2, 4})
+    {
+        const int threadCount = threadMultiplier * hardwareThreads;
+
+        benchmark::RegisterBenchmark("oversubscribed_int64_dynamicSlotMap_growth", oversubscribed_int64_dynamicSlotMap_growth)
+            ->Threads(threadCount)
+            ->Iterations(growthInsertCount / threadCount)
+            ->UseRealTime();
+
+        benchmark::RegisterBenchmark("oversubscribed_int64_dynamicSlotMap_churn",
+                                     oversubscribed_int64_churn<gby::dynamic_slot_map<int64_t>>)
+            ->Threads(threadCount)
+            ->UseRealTime();
+
+        benchmark::RegisterBenchmark("oversubscribed_int64_optimizedLockedSlotMap_churn",
+                                     oversubscribed_int64_churn<gby::optimized_locked_slot_map<int64_t, 1 << 16>>)
+            ->Threads(threadCount)
+            ->UseRealTime();
+
+        benchmark::RegisterBenchmark("oversubscribed_int64_lockFreeConstSizedSlotMap_churn",
+                                     oversubscribed_int64_churn<gby::lock_free_const_sized_slot_map<int64_t, 1 << 16>>)
+            ->Threads(threadCount)
+            ->UseRealTime();
+    }
+}
+
+static const bool oversubscribedBenchmarksRegistered = (registerOversubscribedBenchmarks(), true);
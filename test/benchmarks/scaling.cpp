@@ -0,0 +1,184 @@
+
+#include "locked_slot_map.h"
+#include "optimized_locked_slot_map.h"
+#include "lock_free_const_sized_slot_map.h"
+#include "dynamic_slot_map.h"
+
+#include "../BaselineMaps.h"
+#include "BenchmarkHelpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Every benchmark here runs its operation concurrently on a single shared map,
+// from 1 up to hardware_concurrency threads. Besides the overall throughput it
+// reports the throughput per thread - where that starts dropping is where the
+// engine stops scaling.
+
+// power of 2, so that picking a random key is a mask rather than a modulo
+constexpr size_t scalingElementCount {1 << 16};
+
+void setThroughput(benchmark::State& state, const int64_t items_, const PerfCounters& perf_,
+                   const AllocationCounter& allocations_)
+{
+    setPerfCounters(state, perf_, static_cast<double>(items_) / state.iterations());
+    setAllocationCounters(state, allocations_, static_cast<double>(items_) / state.iterations());
+    state.SetItemsProcessed(items_);
+    state.counters["items_per_second_per_thread"] =
+        benchmark::Counter(static_cast<double>(items_), benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+}
+
+template<typename Map>
+void populateSharedMap()
+{
+    sharedMap<Map> = makeMap<Map>(scalingElementCount);
+    sharedKeys<Map>.clear();
+    sharedKeys<Map>.reserve(scalingElementCount);
+    for (size_t i = 0; i < scalingElementCount; ++i)
+        sharedKeys<Map>.push_back(sharedMap<Map>->insert(static_cast<int64_t>(i)));
+}
+
+template<typename Map>
+void clearSharedMap()
+{
+    sharedKeys<Map>.clear();
+    sharedMap<Map>.reset();
+}
+
+
+// runs a fixed amount of iterations (see registerScalingBenchmarks),
+// so that the map never grows past scalingElementCount
+template<typename Map>
+static void scaling_int64_insert(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        sharedMap<Map> = makeMap<Map>(scalingElementCount);
+
+    int64_t val = state.thread_index();
+    PerfCounters perf;
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(sharedMap<Map>->insert(val));
+    }
+    perf.stop();
+    setThroughput(state, state.iterations(), perf, allocations);
+
+    if (state.thread_index() == 0)
+        clearSharedMap<Map>();
+}
+
+template<typename Map>
+static void scaling_int64_find(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        populateSharedMap<Map>();
+
+    std::minstd_rand randomEngine (state.thread_index() + 1);
+    PerfCounters perf;
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        const auto& key = sharedKeys<Map>[randomEngine() & (scalingElementCount-1)];
+        benchmark::DoNotOptimize(contains(*sharedMap<Map>, key));
+    }
+    perf.stop();
+    setThroughput(state, state.iterations(), perf, allocations);
+
+    if (state.thread_index() == 0)
+        clearSharedMap<Map>();
+}
+
+// every thread erases its own slice of the keys, in a fixed amount of iterations
+template<typename Map>
+static void scaling_int64_erase(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        populateSharedMap<Map>();
+
+    size_t keyIdx = state.thread_index() * (scalingElementCount / state.threads());
+    PerfCounters perf;
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        sharedMap<Map>->erase(sharedKeys<Map>[keyIdx++]);
+    }
+    perf.stop();
+    setThroughput(state, state.iterations(), perf, allocations);
+
+    if (state.thread_index() == 0)
+        clearSharedMap<Map>();
+}
+
+template<typename Map>
+static void scaling_int64_iterate(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        populateSharedMap<Map>();
+
+    int64_t sum {};
+    PerfCounters perf;
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        sharedMap<Map>->iterate_map([&sum](const int64_t& val) { sum += val; });
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    setThroughput(state, state.iterations() * scalingElementCount, perf, allocations);
+
+    if (state.thread_index() == 0)
+        clearSharedMap<Map>();
+}
+
+
+std::vector<int> scalingThreadCounts()
+{
+    std::vector<int> threadCounts {};
+    for (int threads = 1; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+    return threadCounts;
+}
+
+template<typename Map>
+void registerScalingBenchmarks(const std::string& engine_)
+{
+    for (int threads : scalingThreadCounts())
+    {
+        const auto fixedIterations = static_cast<benchmark::IterationCount>(scalingElementCount / threads);
+
+        benchmark::RegisterBenchmark(("scaling_int64_insert_" + engine_).c_str(), scaling_int64_insert<Map>)
+            ->Threads(threads)->Iterations(fixedIterations)->UseRealTime();
+
+        benchmark::RegisterBenchmark(("scaling_int64_find_" + engine_).c_str(), scaling_int64_find<Map>)
+            ->Threads(threads)->UseRealTime();
+
+        benchmark::RegisterBenchmark(("scaling_int64_erase_" + engine_).c_str(), scaling_int64_erase<Map>)
+            ->Threads(threads)->Iterations(fixedIterations)->UseRealTime();
+
+        benchmark::RegisterBenchmark(("scaling_int64_iterate_" + engine_).c_str(), scaling_int64_iterate<Map>)
+            ->Threads(threads)->UseRealTime();
+    }
+}
+
+static const bool scalingBenchmarksRegistered = []
+{
+    registerScalingBenchmarks<gby::locked_slot_map<int64_t>>("lockedSlotMap");
+    registerScalingBenchmarks<gby::optimized_locked_slot_map<int64_t, scalingElementCount>>("optimizedLockedSlotMap");
+    registerScalingBenchmarks<gby::lock_free_const_sized_slot_map<int64_t, scalingElementCount>>("lockFreeConstSizedSlotMap");
+    registerScalingBenchmarks<gby::dynamic_slot_map<int64_t>>("dynamicSlotMap");
+    registerScalingBenchmarks<MutexSlotMap<int64_t>>("sg14SlotMapMutex");
+    registerScalingBenchmarks<SharedMutexUnorderedMap<int64_t>>("unorderedMapSharedMutex");
+    registerScalingBenchmarks<SpinlockSlotMap<int64_t>>("sg14SlotMapSpinlock");
+    registerScalingBenchmarks<ShardedUnorderedMap<int64_t>>("shardedUnorderedMap");
+    registerScalingBenchmarks<OpenAddressingHashMap<int64_t>>("openAddressingHashMap");
+    return true;
+}();
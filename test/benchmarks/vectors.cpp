@@ -0,0 +1,249 @@
+
+#include "internal_vector.h"
+#include "lock_free_vector.h"
+
+#include "BenchmarkHelpers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// internal_vector and lock_free_vector against the std containers they stand
+// in for: push_back, indexed access, iteration (through iterators, and through
+// iterate_over where there is one) and concurrent push_back.
+
+// both gby vectors hold just under 2^17 elements with their default bucket sizes
+constexpr size_t vectorElementCount {1 << 16};
+
+// std::vector behind a mutex - the straightforward thread safe vector
+template<typename T>
+class MutexVector
+{
+public:
+    void push_back(const T& val_)
+    {
+        std::lock_guard lg {_mut};
+        _vec.push_back(val_);
+    }
+
+    T operator[](const size_t idx_)
+    {
+        std::lock_guard lg {_mut};
+        return _vec[idx_];
+    }
+
+    void reserve(const size_t size_)
+    {
+        std::lock_guard lg {_mut};
+        _vec.reserve(size_);
+    }
+
+    size_t size()
+    {
+        std::lock_guard lg {_mut};
+        return _vec.size();
+    }
+
+    // not guarded, iterated only while no one pushes
+    auto begin() { return _vec.begin(); }
+    auto end()   { return _vec.end(); }
+
+private:
+    std::mutex     _mut;
+    std::vector<T> _vec;
+};
+
+// std::vector reserved up front, to tell apart the cost of its reallocations
+template<typename T>
+struct ReservedVector : std::vector<T>
+{
+    ReservedVector() { this->reserve(vectorElementCount); }
+};
+
+using InternalVector = gby::internal_vector<int64_t>;
+using LockFreeVector = gby::lock_free_vector<int64_t>;
+using StdVector      = std::vector<int64_t>;
+using StdVectorReserved = ReservedVector<int64_t>;
+using StdDeque       = std::deque<int64_t>;
+using MutexStdVector = MutexVector<int64_t>;
+
+// vector shared by the threads of vector_int64_concurrentPushBack
+template<typename Vec>
+std::unique_ptr<Vec> sharedVector {};
+
+template<typename Vec>
+std::unique_ptr<Vec> makeFilledVector()
+{
+    auto vec = std::make_unique<Vec>();
+    for (size_t i = 0; i < vectorElementCount; ++i)
+        vec->push_back(static_cast<int64_t>(i));
+    return vec;
+}
+
+void setVectorCounters(benchmark::State& state, const PerfCounters& perf_, const AllocationCounter& allocations_,
+                       const size_t itemsPerIteration_)
+{
+    setPerfCounters(state, perf_, static_cast<double>(itemsPerIteration_));
+    setAllocationCounters(state, allocations_, static_cast<double>(itemsPerIteration_));
+    state.SetItemsProcessed(state.iterations() * itemsPerIteration_);
+    state.counters["time_per_item"] = benchmark::Counter(static_cast<double>(itemsPerIteration_),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+
+template<typename Vec>
+static void vector_int64_pushBack(benchmark::State& state)
+{
+    PerfCounters perf;
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        pauseTiming(state, perf);
+        auto vec = std::make_unique<Vec>();
+        resumeTiming(state, perf);
+
+        for (size_t i = 0; i < vectorElementCount; ++i)
+            vec->push_back(static_cast<int64_t>(i));
+        benchmark::DoNotOptimize(vec.get());
+
+        pauseTiming(state, perf);
+        vec.reset();
+        resumeTiming(state, perf);
+    }
+    perf.stop();
+    setVectorCounters(state, perf, allocations, vectorElementCount);
+}
+
+template<typename Vec>
+static void vector_int64_index(benchmark::State& state)
+{
+    auto vec = makeFilledVector<Vec>();
+
+    PerfCounters perf;
+
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        int64_t sum {};
+        for (size_t i = 0; i < vectorElementCount; ++i)
+            sum += (*vec)[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    setVectorCounters(state, perf, allocations, vectorElementCount);
+}
+
+template<typename Vec>
+static void vector_int64_iterator(benchmark::State& state)
+{
+    auto vec = makeFilledVector<Vec>();
+
+    PerfCounters perf;
+
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        int64_t sum {};
+        for (auto it = vec->begin(); it != vec->end(); ++it)
+            sum += *it;
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    setVectorCounters(state, perf, allocations, vectorElementCount);
+}
+
+template<typename Vec>
+static void vector_int64_iterateOver(benchmark::State& state)
+{
+    auto vec = makeFilledVector<Vec>();
+
+    PerfCounters perf;
+
+    AllocationCounter allocations;
+    perf.start();
+    for (auto _ : state)
+    {
+        int64_t sum {};
+        vec->iterate_over([&sum](const int64_t& val) { sum += val; });
+        benchmark::DoNotOptimize(sum);
+    }
+    perf.stop();
+    setVectorCounters(state, perf, allocations, vectorElementCount);
+}
+
+// every thread pushes its share of vectorElementCount elements into one
+// shared vector, a fixed amount of iterations so that it never overflows
+template<typename Vec>
+static void vector_int64_concurrentPushBack(benchmark::State& state)
+{
+    if (state.thread_index() == 0)
+        sharedVector<Vec> = std::make_unique<Vec>();
+
+    PerfCounters perf;
+
+    AllocationCounter allocations;
+    int64_t val = state.thread_index();
+    perf.start();
+    for (auto _ : state)
+    {
+        sharedVector<Vec>->push_back(val);
+        val += state.threads();
+    }
+    perf.stop();
+    setPerfCounters(state, perf);
+    setAllocationCounters(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0)
+        sharedVector<Vec>.reset();
+}
+
+
+template<typename Vec>
+void registerVectorBenchmarks(const std::string& name_)
+{
+    benchmark::RegisterBenchmark(("vector_int64_pushBack_" + name_).c_str(), vector_int64_pushBack<Vec>);
+    benchmark::RegisterBenchmark(("vector_int64_index_" + name_).c_str(), vector_int64_index<Vec>);
+    benchmark::RegisterBenchmark(("vector_int64_iterator_" + name_).c_str(), vector_int64_iterator<Vec>);
+
+    if constexpr (requires (Vec& vec_) { vec_.iterate_over([](const int64_t&) {}); })
+        benchmark::RegisterBenchmark(("vector_int64_iterateOver_" + name_).c_str(), vector_int64_iterateOver<Vec>);
+}
+
+// only the vectors safe to push_back into concurrently
+template<typename Vec>
+void registerConcurrentVectorBenchmarks(const std::string& name_)
+{
+    for (int threads = 1; ; threads = std::min(2*threads, hardwareThreads))
+    {
+        benchmark::RegisterBenchmark(("vector_int64_concurrentPushBack_" + name_).c_str(), vector_int64_concurrentPushBack<Vec>)
+            ->Threads(threads)
+            ->Iterations(static_cast<benchmark::IterationCount>(vectorElementCount / threads))
+            ->UseRealTime();
+        if (threads == hardwareThreads)
+            break;
+    }
+}
+
+static const bool vectorBenchmarksRegistered = []
+{
+    registerVectorBenchmarks<InternalVector>("internalVector");
+    registerVectorBenchmarks<LockFreeVector>("lockFreeVector");
+    registerVectorBenchmarks<StdVector>("stdVector");
+    registerVectorBenchmarks<StdVectorReserved>("stdVectorReserved");
+    registerVectorBenchmarks<StdDeque>("stdDeque");
+    registerVectorBenchmarks<MutexStdVector>("mutexStdVector");
+
+    registerConcurrentVectorBenchmarks<InternalVector>("internalVector");
+    registerConcurrentVectorBenchmarks<LockFreeVector>("lockFreeVector");
+    registerConcurrentVectorBenchmarks<MutexStdVector>("mutexStdVector");
+    return true;
+}();
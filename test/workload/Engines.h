@@ -0,0 +1,48 @@
+
+#pragma once
+
+// The maps the standalone drivers can be run against, by name.
+
+#include "locked_slot_map.h"
+#include "optimized_locked_slot_map.h"
+#include "lock_free_const_sized_slot_map.h"
+#include "dynamic_slot_map.h"
+
+#include "../BaselineMaps.h"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// capacity of the fixed sized maps, inserts into a full map are counted as failed
+constexpr size_t workloadFixedCapacity {1 << 16};
+
+constexpr std::array<const char*, 9> engineNames {
+    "lockedSlotMap",
+    "optimizedLockedSlotMap",
+    "lockFreeConstSizedSlotMap",
+    "dynamicSlotMap",
+    "sg14SlotMapMutex",
+    "sg14SlotMapSpinlock",
+    "unorderedMapSharedMutex",
+    "shardedUnorderedMap",
+    "openAddressingHashMap"
+};
+
+// calls fnc_ with a std::type_identity of the map of values T named engine_
+template<typename T, typename Fnc>
+void withEngine(const std::string& engine_, Fnc&& fnc_)
+{
+    if      (engine_ == "lockedSlotMap")             fnc_(std::type_identity<gby::locked_slot_map<T>>{});
+    else if (engine_ == "optimizedLockedSlotMap")    fnc_(std::type_identity<gby::optimized_locked_slot_map<T, workloadFixedCapacity>>{});
+    else if (engine_ == "lockFreeConstSizedSlotMap") fnc_(std::type_identity<gby::lock_free_const_sized_slot_map<T, workloadFixedCapacity>>{});
+    else if (engine_ == "dynamicSlotMap")            fnc_(std::type_identity<gby::dynamic_slot_map<T>>{});
+    else if (engine_ == "sg14SlotMapMutex")          fnc_(std::type_identity<MutexSlotMap<T>>{});
+    else if (engine_ == "sg14SlotMapSpinlock")       fnc_(std::type_identity<SpinlockSlotMap<T>>{});
+    else if (engine_ == "unorderedMapSharedMutex")   fnc_(std::type_identity<SharedMutexUnorderedMap<T>>{});
+    else if (engine_ == "shardedUnorderedMap")       fnc_(std::type_identity<ShardedUnorderedMap<T>>{});
+    else if (engine_ == "openAddressingHashMap")     fnc_(std::type_identity<OpenAddressingHashMap<T>>{});
+    else
+        throw std::invalid_argument("unknown engine: " + engine_);
+}
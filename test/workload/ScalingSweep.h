@@ -0,0 +1,229 @@
+
+#pragma once
+
+// Thread-scaling sweep: runs concurrent writers and readers against one shared
+// map for every combination of 1, 2, 4 ... N writers and readers, measuring
+// the throughput of each configuration. See scalingSweep.cpp.
+
+#include "../CpuTopology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <latch>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// every writer keeps at most this many of its own elements in the map,
+// erasing its oldest one once over it - so the map stays about its initial size
+constexpr size_t sweepWriterWindow {256};
+
+struct SweepOptions
+{
+    std::vector<std::string> engines    {};     // empty for all of them
+    unsigned                 maxThreads {std::max(1u, std::thread::hardware_concurrency())};
+    double                   duration   {1};    // in seconds, per configuration
+    size_t                   records    {10000};// inserted before every configuration
+    std::string              format     {"csv"};
+    std::string              output     {};     // empty for stdout
+    PinningPolicy            pinning    {PinningPolicy::None};
+};
+
+struct SweepResult
+{
+    std::string              engine;
+    unsigned                 writers {};
+    unsigned                 readers {};
+    std::chrono::nanoseconds elapsed {};
+    uint64_t                 writes {};         // inserts and erases
+    uint64_t                 reads {};
+    uint64_t                 failedWrites {};   // inserts into a full map
+    std::string              placement {};      // cpus of the writers, then the readers
+
+    double seconds() const { return std::chrono::duration<double>(elapsed).count(); }
+    double writesPerSecond() const { return writes / seconds(); }
+    double readsPerSecond()  const { return reads / seconds(); }
+    double opsPerSecond()    const { return (writes + reads) / seconds(); }
+    double opsPerSecondPerThread() const { return opsPerSecond() / (writers + readers); }
+};
+
+// 1, 2, 4 ... up to and including maxThreads_
+inline std::vector<unsigned> sweepThreadCounts(const unsigned maxThreads_)
+{
+    std::vector<unsigned> threadCounts {};
+    for (unsigned threads = 1; threads < maxThreads_; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads_);
+    return threadCounts;
+}
+
+
+template<typename Map>
+class SweepConfiguration
+{
+public:
+    using key_type = typename Map::key_type;
+
+    SweepConfiguration(const unsigned writers_, const unsigned readers_, const SweepOptions& options_)
+            : _writers {writers_}
+            , _readers {readers_}
+            , _options {options_}
+    {}
+
+    SweepResult run()
+    {
+        auto map = std::make_unique<Map>();
+        if constexpr (requires { map->reserve(_options.records); })
+            map->reserve(_options.records);
+
+        // the preloaded elements are only ever read, so their keys can be shared lock free
+        std::vector<key_type> keys;
+        keys.reserve(_options.records);
+        for (size_t i = 0; i < _options.records; ++i)
+            keys.push_back(map->insert(static_cast<int64_t>(i)));
+
+        // writers go first, then the readers
+        const auto cpus = CpuTopology::get().placement(_options.pinning, _writers + _readers);
+
+        std::vector<SweepResult> threadResults (_writers + _readers);
+        std::latch start {static_cast<std::ptrdiff_t>(_writers + _readers) + 1};
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < _writers; ++i)
+            threads.emplace_back([&, i] { pinCurrentThread(cpus[i]); start.arrive_and_wait(); threadResults[i] = runWriter(*map, i); });
+        for (unsigned i = 0; i < _readers; ++i)
+            threads.emplace_back([&, i] { pinCurrentThread(cpus[_writers + i]); start.arrive_and_wait(); threadResults[_writers + i] = runReader(*map, keys, i); });
+
+        start.arrive_and_wait();
+        const auto timeStart = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(_options.duration));
+        _stop.store(true, std::memory_order_relaxed);
+        for (auto& thread : threads)
+            thread.join();
+
+        SweepResult result {};
+        result.elapsed = std::chrono::steady_clock::now() - timeStart;
+        result.writers = _writers;
+        result.readers = _readers;
+        result.placement = placementString(cpus);
+        for (const auto& threadResult : threadResults)
+        {
+            result.writes       += threadResult.writes;
+            result.reads        += threadResult.reads;
+            result.failedWrites += threadResult.failedWrites;
+        }
+        return result;
+    }
+
+private:
+    // "0 1 2 3", or "unpinned"
+    static std::string placementString(const std::vector<int>& cpus_)
+    {
+        if (cpus_.empty() || cpus_.front() < 0)
+            return "unpinned";
+
+        std::string placement;
+        for (int cpu : cpus_)
+            placement += (placement.empty() ? "" : " ") + std::to_string(cpu);
+        return placement;
+    }
+
+    SweepResult runWriter(Map& map_, const unsigned writerIdx_)
+    {
+        SweepResult result {};
+        std::deque<key_type> ownKeys {};
+        int64_t val = _options.records + writerIdx_;
+        while (!_stop.load(std::memory_order_relaxed))
+        {
+            bool full {false};
+            try
+            {
+                ownKeys.push_back(map_.insert(val));
+            }
+            catch (const std::length_error&)
+            {
+                ++result.failedWrites;
+                full = true;
+            }
+            val += _writers;
+            ++result.writes;
+
+            // a full map (the fixed sized ones) gets an element freed up as well
+            if (ownKeys.size() > sweepWriterWindow || (full && !ownKeys.empty()))
+            {
+                map_.erase(ownKeys.front());
+                ownKeys.pop_front();
+                ++result.writes;
+            }
+        }
+        return result;
+    }
+
+    SweepResult runReader(Map& map_, const std::vector<key_type>& keys_, const unsigned readerIdx_)
+    {
+        SweepResult result {};
+        std::minstd_rand randomEngine (readerIdx_ + 1);
+        std::uniform_int_distribution<size_t> keyDistribution {0, keys_.size() - 1};
+        int64_t found {};
+        while (!_stop.load(std::memory_order_relaxed))
+        {
+            const auto& key = keys_[keyDistribution(randomEngine)];
+            // locked_slot_map hands out iterators into its container, which a
+            // concurrent insert may reallocate - so they're not dereferenced
+            if constexpr (requires { map_.find(key).has_value(); })
+                found += map_.find(key).has_value();
+            else
+                found += map_.find(key) != map_.end();
+            ++result.reads;
+        }
+        _sink.fetch_add(found, std::memory_order_relaxed);
+        return result;
+    }
+
+    const unsigned          _writers;
+    const unsigned          _readers;
+    const SweepOptions&     _options;
+    std::atomic<bool>       _stop {false};
+    std::atomic<int64_t>    _sink {};   // keeps the reads from being optimized away
+};
+
+
+inline void writeCsv(std::ostream& os_, const std::vector<SweepResult>& results_)
+{
+    os_ << "engine,writers,readers,placement,seconds,writes,reads,failed_writes,"
+           "writes_per_second,reads_per_second,ops_per_second,ops_per_second_per_thread\n";
+    for (const auto& r : results_)
+        os_ << r.engine << "," << r.writers << "," << r.readers << "," << r.placement << "," << r.seconds() << ","
+            << r.writes << "," << r.reads << "," << r.failedWrites << ","
+            << r.writesPerSecond() << "," << r.readsPerSecond() << ","
+            << r.opsPerSecond() << "," << r.opsPerSecondPerThread() << "\n";
+}
+
+inline void writeJson(std::ostream& os_, const std::vector<SweepResult>& results_)
+{
+    os_ << "[\n";
+    for (size_t i = 0; i < results_.size(); ++i)
+    {
+        const auto& r = results_[i];
+        os_ << "  {\"engine\": \"" << r.engine << "\""
+            << ", \"writers\": " << r.writers
+            << ", \"readers\": " << r.readers
+            << ", \"placement\": \"" << r.placement << "\""
+            << ", \"seconds\": " << r.seconds()
+            << ", \"writes\": " << r.writes
+            << ", \"reads\": " << r.reads
+            << ", \"failed_writes\": " << r.failedWrites
+            << ", \"writes_per_second\": " << r.writesPerSecond()
+            << ", \"reads_per_second\": " << r.readsPerSecond()
+            << ", \"ops_per_second\": " << r.opsPerSecond()
+            << ", \"ops_per_second_per_thread\": " << r.opsPerSecondPerThread()
+            << "}" << (i + 1 < results_.size() ? "," : "") << "\n";
+    }
+    os_ << "]\n";
+}
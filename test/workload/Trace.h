@@ -0,0 +1,294 @@
+
+#pragma once
+
+// Binary operation traces: TraceRecorder wraps a map and logs every operation
+// made through it, TraceReplay.h drives a recorded trace against any engine.
+//
+// A trace file is a TraceHeader followed by its records, ordered by timestamp,
+// in the byte order of the machine that recorded it. Keys are recorded as the
+// index of the insert that returned them, so that a trace can be replayed
+// against an engine with a different key type.
+
+#include "Workload.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct TraceRecord
+{
+    uint64_t timestamp {};  // nanoseconds since the recording started
+    uint64_t key       {};  // index of the insert that returned the key, noTraceKey if there is none
+    uint32_t valueSize {};  // bytes inserted or read, 0 for erases and iterations
+    uint16_t thread    {};  // in order of the threads' first operation
+    uint8_t  operation {};  // an Operation
+    uint8_t  reserved  {};
+};
+
+static_assert(sizeof(TraceRecord) == 24 && std::is_trivially_copyable_v<TraceRecord>);
+
+// iterations, failed inserts and reads/erases of keys that weren't inserted through the recorder
+constexpr uint64_t noTraceKey {std::numeric_limits<uint64_t>::max()};
+
+struct TraceHeader
+{
+    std::array<char, 8> magic   {'G', 'B', 'Y', 'T', 'R', 'A', 'C', 'E'};
+    uint32_t            version {1};
+    uint32_t            threads {};
+    uint64_t            records {};
+    uint64_t            keys    {};  // amount of inserts that returned a key
+};
+
+static_assert(sizeof(TraceHeader) == 32 && std::is_trivially_copyable_v<TraceHeader>);
+
+struct Trace
+{
+    uint32_t                 threads {};
+    uint64_t                 keys    {};
+    std::vector<TraceRecord> records {};
+};
+
+inline void saveTrace(const std::string& path_, const Trace& trace_)
+{
+    std::ofstream file {path_, std::ios::binary};
+    if (!file)
+        throw std::runtime_error("can't open trace file for writing: " + path_);
+
+    TraceHeader header {};
+    header.threads = trace_.threads;
+    header.records = trace_.records.size();
+    header.keys    = trace_.keys;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(trace_.records.data()),
+               static_cast<std::streamsize>(trace_.records.size() * sizeof(TraceRecord)));
+    if (!file)
+        throw std::runtime_error("failed writing trace file: " + path_);
+}
+
+inline Trace loadTrace(const std::string& path_)
+{
+    std::ifstream file {path_, std::ios::binary};
+    if (!file)
+        throw std::runtime_error("can't open trace file: " + path_);
+
+    TraceHeader header {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != TraceHeader{}.magic)
+        throw std::runtime_error("not a trace file: " + path_);
+    if (header.version != TraceHeader{}.version)
+        throw std::runtime_error("unsupported trace version " + std::to_string(header.version) + ": " + path_);
+
+    Trace trace {header.threads, header.keys, std::vector<TraceRecord>(header.records)};
+    file.read(reinterpret_cast<char*>(trace.records.data()),
+              static_cast<std::streamsize>(trace.records.size() * sizeof(TraceRecord)));
+    if (!file)
+        throw std::runtime_error("truncated trace file: " + path_);
+
+    for (const auto& record : trace.records)
+    {
+        if (record.thread >= trace.threads || record.operation >= allOperations.size() ||
+            (record.key != noTraceKey && record.key >= trace.keys))
+            throw std::runtime_error("corrupt trace file: " + path_);
+    }
+    return trace;
+}
+
+
+// Decorator logging every insert/find/erase/iterate_map made through it, for
+// saving as a trace once the recorded run is done. Every thread logs into a
+// buffer of its own, so the only shared state on the way is the key table.
+// A thread is expected to record into one recorder at a time.
+template<typename Map>
+class TraceRecorder
+{
+public:
+    using key_type   = typename Map::key_type;
+    using value_type = typename Map::value_type;
+
+    explicit TraceRecorder(Map& map_)
+            : _map {map_}
+    {}
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    template<typename V>
+    key_type insert(V&& val_)
+    {
+        const auto start = now();
+        const auto size  = valueSize(val_);
+        try
+        {
+            const key_type key = _map.insert(std::forward<V>(val_));
+            const uint64_t id  = _nextKeyId.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::unique_lock ul {_keysMut};
+                _keyIds[keyBits(key)] = id;
+            }
+            log(Operation::Insert, start, id, size);
+            return key;
+        }
+        catch (...)
+        {
+            log(Operation::Insert, start, noTraceKey, size);
+            throw;
+        }
+    }
+
+    auto find(const key_type& key_)
+    {
+        const auto start  = now();
+        auto       result = _map.find(key_);
+        log(Operation::Read, start, keyId(key_), sizeof(value_type));
+        return result;
+    }
+
+    auto end() requires requires (Map& map) { map.end(); }
+    {
+        return _map.end();
+    }
+
+    decltype(auto) erase(const key_type& key_)
+    {
+        const auto start = now();
+        const auto id    = keyId(key_);
+        if constexpr (std::is_void_v<decltype(_map.erase(key_))>)
+        {
+            _map.erase(key_);
+            log(Operation::Erase, start, id, 0);
+        }
+        else
+        {
+            auto erased = _map.erase(key_);
+            log(Operation::Erase, start, id, 0);
+            return erased;
+        }
+    }
+
+    template<typename P>
+    void iterate_map(P pred_)
+    {
+        const auto start = now();
+        _map.iterate_map(pred_);
+        log(Operation::Iterate, start, noTraceKey, 0);
+    }
+
+    void reserve(const size_t size_) requires requires (Map& map) { map.reserve(size_t{}); }
+    {
+        _map.reserve(size_);
+    }
+
+    // the records of all threads so far, merged by timestamp. Not to be called
+    // while operations are still being recorded.
+    Trace trace() const
+    {
+        Trace trace {};
+        trace.threads = static_cast<uint32_t>(_logs.size());
+        trace.keys    = _nextKeyId.load(std::memory_order_relaxed);
+        for (const auto& threadLog : _logs)
+            trace.records.insert(trace.records.end(), threadLog->records.begin(), threadLog->records.end());
+        std::stable_sort(trace.records.begin(), trace.records.end(),
+                         [](const TraceRecord& lhs_, const TraceRecord& rhs_) { return lhs_.timestamp < rhs_.timestamp; });
+        return trace;
+    }
+
+    void save(const std::string& path_) const
+    {
+        saveTrace(path_, trace());
+    }
+
+private:
+    struct ThreadLog
+    {
+        uint16_t                 thread {};
+        std::vector<TraceRecord> records {};
+    };
+
+    std::chrono::steady_clock::time_point now() const
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    void log(const Operation op_, const std::chrono::steady_clock::time_point start_,
+             const uint64_t key_, const uint32_t valueSize_)
+    {
+        auto& threadLog = currentThreadLog();
+        threadLog.records.push_back(TraceRecord{
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start_ - _start).count()),
+            key_,
+            valueSize_,
+            threadLog.thread,
+            static_cast<uint8_t>(op_)});
+    }
+
+    // registers the calling thread on its first operation through this recorder
+    ThreadLog& currentThreadLog()
+    {
+        thread_local uint64_t   owner {};
+        thread_local ThreadLog* threadLog {};
+        if (owner != _id)
+        {
+            std::lock_guard lg {_logsMut};
+            if (_logs.size() > std::numeric_limits<uint16_t>::max())
+                throw std::length_error("too many threads for a trace");
+            _logs.push_back(std::make_unique<ThreadLog>(ThreadLog{static_cast<uint16_t>(_logs.size())}));
+            threadLog = _logs.back().get();
+            owner     = _id;
+        }
+        return *threadLog;
+    }
+
+    uint64_t keyId(const key_type& key_) const
+    {
+        std::shared_lock sl {_keysMut};
+        const auto it = _keyIds.find(keyBits(key_));
+        return it == _keyIds.end() ? noTraceKey : it->second;
+    }
+
+    // the keys are either integers or a pair of 32 bit index and generation
+    static uint64_t keyBits(const key_type& key_)
+    {
+        if constexpr (std::is_integral_v<key_type>)
+            return static_cast<uint64_t>(key_);
+        else
+        {
+            static_assert(sizeof(key_.first) <= 4 && sizeof(key_.second) <= 4);
+            return static_cast<uint64_t>(key_.first) << 32 | static_cast<uint64_t>(key_.second);
+        }
+    }
+
+    template<typename V>
+    static uint32_t valueSize(const V& val_)
+    {
+        if constexpr (std::is_same_v<std::decay_t<V>, std::string>)
+            return static_cast<uint32_t>(val_.size());
+        else
+            return sizeof(V);
+    }
+
+    inline static std::atomic<uint64_t> _nextId {1};
+
+    Map&                                        _map;
+    const uint64_t                              _id    {_nextId.fetch_add(1, std::memory_order_relaxed)};
+    const std::chrono::steady_clock::time_point _start {std::chrono::steady_clock::now()};
+
+    mutable std::shared_mutex                   _keysMut;
+    std::unordered_map<uint64_t, uint64_t>      _keyIds {};  // keyBits of a key -> index of its insert
+    std::atomic<uint64_t>                       _nextKeyId {};
+
+    std::mutex                                  _logsMut;
+    std::vector<std::unique_ptr<ThreadLog>>     _logs {};
+};
@@ -0,0 +1,183 @@
+
+#pragma once
+
+// Replays a recorded trace (see Trace.h) against a map: every recorded thread
+// gets a thread of its own, running its operations in their recorded order.
+// Paced, every operation waits for its recorded time since the start; unpaced
+// they run back to back. Either way a read/erase of a key first waits for the
+// insert of that key on whichever thread made it, so that the replay keeps the
+// dependencies between the threads that the recorded run had.
+
+#include "Trace.h"
+#include "Workload.h"
+
+#include "../Payload.h"
+
+#include "latency_histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+struct TraceReplayResult
+{
+    WorkloadResult         workload {};
+    // how much later than recorded the paced operations started
+    gby::latency_histogram lag      {};
+};
+
+template<typename Map, typename T>
+class TraceReplay
+{
+public:
+    using key_type = typename Map::key_type;
+
+    TraceReplay(Map& map_, const Trace& trace_, const bool paced_)
+            : _map {map_}
+            , _paced {paced_}
+            , _threadRecords (trace_.threads)
+            , _keys {std::make_unique<ReplayKey[]>(trace_.keys)}
+    {
+        for (const auto& record : trace_.records)
+            _threadRecords[record.thread].push_back(record);
+    }
+
+    TraceReplayResult run()
+    {
+        const auto threadCount = _threadRecords.size();
+        std::vector<TraceReplayResult> threadResults (threadCount);
+        std::latch start {static_cast<std::ptrdiff_t>(threadCount) + 1};
+        std::vector<std::thread> threads;
+        std::chrono::steady_clock::time_point timeStart {};
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                start.arrive_and_wait();
+                threadResults[i] = runThread(_threadRecords[i], timeStart);
+            });
+        }
+
+        timeStart = std::chrono::steady_clock::now();
+        start.arrive_and_wait();
+        for (auto& thread : threads)
+            thread.join();
+
+        TraceReplayResult result {};
+        result.workload.elapsed = std::chrono::steady_clock::now() - timeStart;
+        for (const auto& threadResult : threadResults)
+        {
+            for (size_t op = 0; op < result.workload.operations.size(); ++op)
+                result.workload.operations[op].merge(threadResult.workload.operations[op]);
+            result.lag.merge(threadResult.lag);
+        }
+        return result;
+    }
+
+private:
+    enum class KeyState : uint8_t
+    {
+        Pending,    // not inserted yet
+        Inserted,
+        Failed      // the insert threw, e.g. the map was full
+    };
+
+    struct ReplayKey
+    {
+        key_type              key   {};
+        std::atomic<KeyState> state {KeyState::Pending};
+    };
+
+    TraceReplayResult runThread(const std::vector<TraceRecord>& records_,
+                                const std::chrono::steady_clock::time_point timeStart_)
+    {
+        TraceReplayResult result {};
+        int64_t sum {};
+        for (const auto& record : records_)
+        {
+            if (_paced)
+            {
+                const auto due = timeStart_ + std::chrono::nanoseconds(record.timestamp);
+                std::this_thread::sleep_until(due);
+                result.lag.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - due).count());
+            }
+
+            const auto op = static_cast<Operation>(record.operation);
+            auto& stats   = result.workload.operations[record.operation];
+            const key_type* key {};
+            if ((op == Operation::Read || op == Operation::Erase) && !(key = awaitKey(record.key)))
+            {
+                ++stats.failed;
+                continue;
+            }
+
+            const auto opStart = std::chrono::steady_clock::now();
+            switch (op)
+            {
+                case Operation::Read:
+                    if (!readValue(_map, *key, sum))
+                        ++stats.failed;
+                    break;
+                case Operation::Insert:
+                    if (!insert(record))
+                        ++stats.failed;
+                    break;
+                case Operation::Erase:
+                    _map.erase(*key);
+                    break;
+                case Operation::Iterate:
+                    _map.iterate_map([&sum](const T& val) { sum += sampleValue(val); });
+                    break;
+            }
+            stats.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - opStart).count());
+        }
+        _sink.fetch_add(sum, std::memory_order_relaxed);
+        return result;
+    }
+
+    bool insert(const TraceRecord& record_)
+    {
+        try
+        {
+            const key_type key = _map.insert(makeValue<T>(record_.key));
+            if (record_.key != noTraceKey)
+            {
+                _keys[record_.key].key = key;
+                _keys[record_.key].state.store(KeyState::Inserted, std::memory_order_release);
+            }
+            return true;
+        }
+        catch (const std::length_error&)
+        {
+            if (record_.key != noTraceKey)
+                _keys[record_.key].state.store(KeyState::Failed, std::memory_order_release);
+            return false;
+        }
+    }
+
+    // the key inserted as the traceKey_'th insert, nullptr if it wasn't
+    const key_type* awaitKey(const uint64_t traceKey_) const
+    {
+        if (traceKey_ == noTraceKey)
+            return nullptr;
+
+        const auto& replayKey = _keys[traceKey_];
+        KeyState state;
+        while ((state = replayKey.state.load(std::memory_order_acquire)) == KeyState::Pending)
+            std::this_thread::yield();
+        return state == KeyState::Inserted ? &replayKey.key : nullptr;
+    }
+
+    Map&                                    _map;
+    const bool                              _paced;
+    std::vector<std::vector<TraceRecord>>   _threadRecords;
+    std::unique_ptr<ReplayKey[]>            _keys;      // indexed by the keys' index in the trace
+    std::atomic<int64_t>                    _sink {};   // keeps the reads from being optimized away
+};
@@ -0,0 +1,354 @@
+
+#pragma once
+
+// YCSB-style workload: every thread runs a random mix of reads, inserts, erases
+// and iterations against one shared map for a fixed duration, picking the keys
+// it reads/erases out of its own according to a key distribution. Only the map
+// calls are timed. See workloadDriver.cpp.
+
+#include "../Payload.h"
+
+#include "latency_histogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <latch>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class Operation
+{
+    Read,
+    Insert,
+    Erase,
+    Iterate
+};
+
+constexpr std::array<Operation, 4> allOperations {Operation::Read, Operation::Insert, Operation::Erase, Operation::Iterate};
+
+constexpr const char* operationName(const Operation op_)
+{
+    switch (op_)
+    {
+        case Operation::Read:    return "read";
+        case Operation::Insert:  return "insert";
+        case Operation::Erase:   return "erase";
+        case Operation::Iterate: return "iterate";
+    }
+    return "";
+}
+
+enum class KeyDistribution
+{
+    Uniform,    // every live key is as likely
+    Zipfian,    // a few hot keys, scattered over the live keys
+    Latest      // skewed towards the most recently inserted keys
+};
+
+struct WorkloadOptions
+{
+    std::string     engine        {"dynamicSlotMap"};
+    // relative weights of the operations, indexed by Operation
+    std::array<double, 4> ratios  {90, 5, 5, 0};
+    KeyDistribution distribution  {KeyDistribution::Zipfian};
+    unsigned        threads       {std::max(1u, std::thread::hardware_concurrency())};
+    double          duration      {5};      // in seconds
+    size_t          valueSize     {8};      // in bytes
+    size_t          records       {10000};  // inserted before the workload starts
+    double          zipfianSkew   {0.99};
+    std::string     record        {};       // trace file the run is recorded into, see Trace.h
+};
+
+struct OperationStats
+{
+    gby::latency_histogram latencies {};
+    uint64_t               failed    {}; // reads/erases of missing keys, inserts into a full map
+
+    void merge(const OperationStats& other_)
+    {
+        latencies.merge(other_.latencies);
+        failed += other_.failed;
+    }
+};
+
+struct WorkloadResult
+{
+    std::array<OperationStats, 4> operations {};
+    std::chrono::nanoseconds      elapsed {};
+
+    uint64_t totalOperations() const
+    {
+        uint64_t total {};
+        for (const auto& op : operations)
+            total += op.latencies.count();
+        return total;
+    }
+};
+
+
+// Zipfian distributed ranks in [0, itemCount), rank 0 being the most popular.
+// Gray et al, "Quickly Generating Billion-Record Synthetic Databases" - the
+// same generator YCSB uses, so the skew values are comparable. The skew has to
+// be positive and other than 1, as the generator divides by 1 - skew.
+class ZipfianGenerator
+{
+public:
+    ZipfianGenerator(const size_t itemCount_, const double skew_)
+            : _itemCount {std::max<size_t>(itemCount_, 2)}
+            , _skew {skew_}
+    {
+        for (size_t i = 1; i <= _itemCount; ++i)
+            _zetaN += 1 / std::pow(static_cast<double>(i), _skew);
+
+        const double zeta2 = 1 + 1 / std::pow(2.0, _skew);
+        _alpha = 1 / (1 - _skew);
+        _eta   = (1 - std::pow(2.0 / _itemCount, 1 - _skew)) / (1 - zeta2 / _zetaN);
+    }
+
+    template<typename RandomEngine>
+    size_t operator()(RandomEngine& randomEngine_) const
+    {
+        const double u  = std::uniform_real_distribution<double>{0, 1}(randomEngine_);
+        const double uz = u * _zetaN;
+        if (uz < 1)
+            return 0;
+        if (uz < 1 + std::pow(0.5, _skew))
+            return 1;
+        return static_cast<size_t>(_itemCount * std::pow(_eta*u - _eta + 1, _alpha)) % _itemCount;
+    }
+
+private:
+    size_t _itemCount;
+    double _skew;
+    double _zetaN {};
+    double _alpha {};
+    double _eta {};
+};
+
+// adds a sample of the element of key_ to sum_, false if there is none
+template<typename Map>
+bool readValue(Map& map_, const typename Map::key_type& key_, int64_t& sum_)
+{
+    if constexpr (requires { map_.find(key_).has_value(); })
+    {
+        auto val = map_.find(key_);
+        if (!val)
+            return false;
+        sum_ += sampleValue(val->get());
+    }
+    else
+    {
+        // locked_slot_map hands out iterators into its container, which a
+        // concurrent insert may reallocate - so they're not dereferenced
+        if (map_.find(key_) == map_.end())
+            return false;
+    }
+    return true;
+}
+
+// per operation table of counts, throughput and latency percentiles
+inline void printOperations(std::ostream& os_, const WorkloadResult& result_)
+{
+    const double seconds = std::chrono::duration<double>(result_.elapsed).count();
+
+    os_ << std::left  << std::setw(10) << "operation"
+        << std::right << std::setw(12) << "count"
+        << std::setw(10) << "failed"
+        << std::setw(14) << "ops/s"
+        << std::setw(10) << "p50(ns)"
+        << std::setw(10) << "p90(ns)"
+        << std::setw(10) << "p99(ns)"
+        << std::setw(12) << "p99.9(ns)"
+        << std::setw(12) << "max(ns)" << "\n";
+
+    for (const auto op : allOperations)
+    {
+        const auto& stats = result_.operations[static_cast<size_t>(op)];
+        const auto& hist  = stats.latencies;
+        if (hist.count() == 0)
+            continue;
+
+        os_ << std::left  << std::setw(10) << operationName(op)
+            << std::right << std::setw(12) << hist.count()
+            << std::setw(10) << stats.failed
+            << std::setw(14) << static_cast<uint64_t>(hist.count() / seconds)
+            << std::setw(10) << hist.percentile(50)
+            << std::setw(10) << hist.percentile(90)
+            << std::setw(10) << hist.percentile(99)
+            << std::setw(12) << hist.percentile(99.9)
+            << std::setw(12) << hist.max() << "\n";
+    }
+}
+
+
+template<typename Map, typename T>
+class Workload
+{
+public:
+    using key_type = typename Map::key_type;
+
+    Workload(Map& map_, const WorkloadOptions& options_)
+            : _map {map_}
+            , _options {options_}
+            , _zipfian {options_.records, options_.zipfianSkew}
+            , _threadKeys (options_.threads)
+    {
+        double sum {};
+        for (size_t i = 0; i < _cumulativeRatios.size(); ++i)
+            _cumulativeRatios[i] = (sum += _options.ratios[i]);
+        if (sum <= 0)
+            throw std::invalid_argument("at least one operation ratio has to be positive");
+    }
+
+    WorkloadResult run()
+    {
+        // the preloaded records are dealt out to the threads round robin
+        for (size_t i = 0; i < _options.records; ++i)
+            _threadKeys[i % _options.threads].push_back(_map.insert(makeValue<T>(i)));
+
+        std::vector<WorkloadResult> threadResults (_options.threads);
+        std::latch start {static_cast<std::ptrdiff_t>(_options.threads) + 1};
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < _options.threads; ++i)
+            threads.emplace_back([&, i] { start.arrive_and_wait(); threadResults[i] = runThread(i); });
+
+        start.arrive_and_wait();
+        const auto timeStart = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(_options.duration));
+        _stop.store(true, std::memory_order_relaxed);
+        for (auto& thread : threads)
+            thread.join();
+
+        WorkloadResult result {};
+        result.elapsed = std::chrono::steady_clock::now() - timeStart;
+        for (const auto& threadResult : threadResults)
+            for (size_t op = 0; op < result.operations.size(); ++op)
+                result.operations[op].merge(threadResult.operations[op]);
+        return result;
+    }
+
+private:
+    WorkloadResult runThread(const unsigned threadIdx_)
+    {
+        WorkloadResult result {};
+        std::mt19937_64 randomEngine {threadIdx_ + 1};
+        std::uniform_real_distribution<double> opDistribution {0, _cumulativeRatios.back()};
+        auto& keys = _threadKeys[threadIdx_];
+
+        int64_t sum {};
+        size_t  insertedCount {};
+        while (!_stop.load(std::memory_order_relaxed))
+        {
+            const double draw = opDistribution(randomEngine);
+            size_t opIdx {};
+            while (draw >= _cumulativeRatios[opIdx] && opIdx < _cumulativeRatios.size()-1)
+                ++opIdx;
+
+            auto& stats = result.operations[opIdx];
+            switch (allOperations[opIdx])
+            {
+                case Operation::Read:
+                {
+                    if (keys.empty())
+                    {
+                        ++stats.failed;
+                        break;
+                    }
+                    const key_type key = keys[chooseKeyIdx(randomEngine, keys.size())];
+                    if (!timed(stats, [&] { return readValue(_map, key, sum); }))
+                        ++stats.failed;
+                    break;
+                }
+                case Operation::Insert:
+                {
+                    const T val = makeValue<T>(threadIdx_ + _options.threads * insertedCount++);
+                    if (const auto key = timed(stats, [&] { return insert(val); }))
+                        keys.push_back(*key);
+                    else
+                        ++stats.failed;
+                    break;
+                }
+                case Operation::Erase:
+                {
+                    if (keys.empty())
+                    {
+                        ++stats.failed;
+                        break;
+                    }
+                    const size_t idx = chooseKeyIdx(randomEngine, keys.size());
+                    timed(stats, [&] { _map.erase(keys[idx]); return true; });
+                    keys[idx] = keys.back();
+                    keys.pop_back();
+                    break;
+                }
+                case Operation::Iterate:
+                    timed(stats, [&] { _map.iterate_map([&sum](const T& val) { sum += sampleValue(val); }); return true; });
+                    break;
+            }
+        }
+        _sink.fetch_add(sum, std::memory_order_relaxed);
+        return result;
+    }
+
+    // runs the map call op_, recording its latency (and nothing but it) in stats_
+    template<typename Op>
+    static auto timed(OperationStats& stats_, Op op_)
+    {
+        const auto opStart = std::chrono::steady_clock::now();
+        auto res = op_();
+        stats_.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - opStart).count());
+        return res;
+    }
+
+    template<typename RandomEngine>
+    size_t chooseKeyIdx(RandomEngine& randomEngine_, const size_t count_) const
+    {
+        switch (_options.distribution)
+        {
+            case KeyDistribution::Uniform:
+                return std::uniform_int_distribution<size_t>{0, count_-1}(randomEngine_);
+            case KeyDistribution::Zipfian:
+                // scrambled, so that the hot keys aren't the oldest ones
+                return std::hash<size_t>{}(_zipfian(randomEngine_) * 0x9E3779B97F4A7C15ull) % count_;
+            case KeyDistribution::Latest:
+                return count_ - 1 - _zipfian(randomEngine_) % count_;
+        }
+        return 0;
+    }
+
+    // the fixed sized maps (and the dynamic one, once at its max capacity) throw when full
+    std::optional<key_type> insert(const T& val_)
+    {
+        try
+        {
+            return _map.insert(val_);
+        }
+        catch (const std::length_error&)
+        {
+            return {};
+        }
+    }
+
+    Map&                    _map;
+    const WorkloadOptions&  _options;
+    ZipfianGenerator        _zipfian;
+    std::array<double, 4>   _cumulativeRatios {};
+    // the keys of the live elements each thread inserted, in insertion order
+    // (erases move the last key into the erased one's place). Every thread
+    // only reads and erases its own, so keeping track of them takes no
+    // synchronization that would end up in the measured latencies.
+    std::vector<std::vector<key_type>> _threadKeys;
+    std::atomic<bool>       _stop {false};
+    std::atomic<int64_t>    _sink {};   // keeps the reads from being optimized away
+};
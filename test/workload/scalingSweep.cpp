@@ -0,0 +1,136 @@
+
+// Standalone thread-scaling sweep, writing the throughput of every engine at
+// every writer/reader count as CSV or JSON - to plot the scaling curves with
+// and to compare between releases. e.g.:
+//
+//   GBY_SlotMap_ScalingSweep --engines=dynamicSlotMap,lockFreeConstSizedSlotMap
+//                            --max-threads=16 --duration=2 --pinning=scatter --format=json --output=scaling.json
+
+#include "Engines.h"
+#include "ScalingSweep.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+void printUsage()
+{
+    std::cout << "Usage: GBY_SlotMap_ScalingSweep [options]\n"
+              << "  --engines=NAME[,NAME...]   any of (default all):";
+    for (const auto* name : engineNames)
+        std::cout << " " << name;
+    std::cout << "\n"
+              << "  --max-threads=N            writers and readers are swept over 1, 2, 4 ... N (default hardware concurrency)\n"
+              << "  --duration=SECONDS         of every configuration (default 1)\n"
+              << "  --records=N                elements inserted before every configuration (default 10000)\n"
+              << "  --pinning=POLICY           none, compact, scatter, same-socket or cross-socket (default none)\n"
+              << "  --format=FORMAT            csv or json (default csv)\n"
+              << "  --output=PATH              (default stdout)\n";
+}
+
+std::vector<std::string> parseEngines(const std::string& engines_)
+{
+    std::vector<std::string> engines;
+    std::istringstream ss {engines_};
+    std::string engine;
+    while (std::getline(ss, engine, ','))
+        engines.push_back(engine);
+    return engines;
+}
+
+SweepOptions parseOptions(int argc, char** argv)
+{
+    SweepOptions options {};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg {argv[i]};
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(EXIT_SUCCESS);
+        }
+
+        const auto eq = arg.find('=');
+        if (!arg.starts_with("--") || eq == std::string_view::npos)
+            throw std::invalid_argument("expected --option=value, got: " + std::string{arg});
+
+        const std::string_view name  = arg.substr(2, eq - 2);
+        const std::string      value {arg.substr(eq + 1)};
+        if      (name == "engines")     options.engines    = parseEngines(value);
+        else if (name == "max-threads") options.maxThreads = std::stoul(value);
+        else if (name == "duration")    options.duration   = std::stod(value);
+        else if (name == "records")     options.records    = std::stoul(value);
+        else if (name == "pinning")     options.pinning    = parsePinningPolicy(value);
+        else if (name == "format")      options.format     = value;
+        else if (name == "output")      options.output     = value;
+        else
+            throw std::invalid_argument("unknown option: " + std::string{arg});
+    }
+
+    if (options.maxThreads == 0)
+        throw std::invalid_argument("max-threads has to be positive");
+    if (options.records == 0)
+        throw std::invalid_argument("records has to be positive");
+    if (options.format != "csv" && options.format != "json")
+        throw std::invalid_argument("unknown format: " + options.format);
+    if (options.engines.empty())
+        options.engines.assign(engineNames.begin(), engineNames.end());
+    return options;
+}
+
+std::vector<SweepResult> runSweep(const SweepOptions& options_)
+{
+    std::vector<SweepResult> results;
+    const auto threadCounts = sweepThreadCounts(options_.maxThreads);
+    for (const auto& engine : options_.engines)
+    {
+        withEngine<int64_t>(engine, [&]<typename Map>(std::type_identity<Map>)
+        {
+            for (unsigned writers : threadCounts)
+            {
+                for (unsigned readers : threadCounts)
+                {
+                    // progress goes to stderr, so that stdout is just the results
+                    std::cerr << engine << ": " << writers << " writers, " << readers << " readers" << std::endl;
+                    auto result = SweepConfiguration<Map>{writers, readers, options_}.run();
+                    result.engine = engine;
+                    results.push_back(std::move(result));
+                }
+            }
+        });
+    }
+    return results;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto options = parseOptions(argc, argv);
+        const auto results = runSweep(options);
+
+        std::ofstream file;
+        if (!options.output.empty())
+        {
+            file.open(options.output);
+            if (!file)
+                throw std::runtime_error("can't open " + options.output);
+        }
+        std::ostream& os = options.output.empty() ? std::cout : file;
+
+        if (options.format == "json")
+            writeJson(os, results);
+        else
+            writeCsv(os, results);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "error: " << e.what() << "\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+
+// Replays a trace recorded with GBY_SlotMap_WorkloadDriver --record=PATH (or
+// any map wrapped in a TraceRecorder) against any of the maps. e.g.:
+//
+//   GBY_SlotMap_TraceReplay --trace=production.trace --engine=lockFreeConstSizedSlotMap --pacing=fast
+
+#include "Engines.h"
+#include "Trace.h"
+#include "TraceReplay.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct ReplayOptions
+{
+    std::string trace     {};
+    std::string engine    {"dynamicSlotMap"};
+    bool        paced     {true};
+    size_t      valueSize {};   // 0 for the value size of the trace's inserts
+};
+
+void printUsage()
+{
+    std::cout << "Usage: GBY_SlotMap_TraceReplay --trace=PATH [options]\n"
+              << "  --engine=NAME              one of:";
+    for (const auto* name : engineNames)
+        std::cout << " " << name;
+    std::cout << "\n"
+              << "  --pacing=PACING            original (recorded timing) or fast (back to back) (default original)\n"
+              << "  --value-size=BYTES         8, 64, 256, 1024 or 4096 (default the trace's)\n";
+}
+
+bool parsePacing(const std::string& pacing_)
+{
+    if (pacing_ == "original") return true;
+    if (pacing_ == "fast")     return false;
+    throw std::invalid_argument("unknown pacing: " + pacing_);
+}
+
+ReplayOptions parseOptions(int argc, char** argv)
+{
+    ReplayOptions options {};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg {argv[i]};
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(EXIT_SUCCESS);
+        }
+
+        const auto eq = arg.find('=');
+        if (!arg.starts_with("--") || eq == std::string_view::npos)
+            throw std::invalid_argument("expected --option=value, got: " + std::string{arg});
+
+        const std::string_view name  = arg.substr(2, eq - 2);
+        const std::string      value {arg.substr(eq + 1)};
+        if      (name == "trace")       options.trace     = value;
+        else if (name == "engine")      options.engine    = value;
+        else if (name == "pacing")      options.paced     = parsePacing(value);
+        else if (name == "value-size")  options.valueSize = std::stoul(value);
+        else
+            throw std::invalid_argument("unknown option: " + std::string{arg});
+    }
+
+    if (options.trace.empty())
+        throw std::invalid_argument("no trace given");
+    return options;
+}
+
+// the value size of the trace's first insert, 8 if there is none
+size_t traceValueSize(const Trace& trace_)
+{
+    for (const auto& record : trace_.records)
+    {
+        if (static_cast<Operation>(record.operation) == Operation::Insert)
+            return record.valueSize;
+    }
+    return 8;
+}
+
+void printResult(const ReplayOptions& options_, const Trace& trace_, const TraceReplayResult& result_)
+{
+    const double seconds = std::chrono::duration<double>(result_.workload.elapsed).count();
+    const double recordedSeconds = trace_.records.empty() ? 0 : trace_.records.back().timestamp / 1e9;
+
+    std::cout << "engine: "     << options_.engine
+              << ", trace: "      << options_.trace
+              << ", threads: "    << trace_.threads
+              << ", pacing: "     << (options_.paced ? "original" : "fast")
+              << ", value size: " << options_.valueSize << "B\n"
+              << "replayed " << trace_.records.size() << " operations recorded over " << recordedSeconds << "s in "
+              << seconds << "s, " << static_cast<uint64_t>(result_.workload.totalOperations() / seconds) << " ops/s\n";
+    if (options_.paced)
+    {
+        std::cout << "start lag behind the recording, p50: " << result_.lag.percentile(50)
+                  << "ns p99: " << result_.lag.percentile(99) << "ns max: " << result_.lag.max() << "ns\n";
+    }
+    std::cout << "\n";
+
+    printOperations(std::cout, result_.workload);
+}
+
+template<typename Map, typename T>
+void runReplay(const ReplayOptions& options_, const Trace& trace_)
+{
+    auto map = std::make_unique<Map>();
+    if constexpr (requires { map->reserve(trace_.keys); })
+        map->reserve(trace_.keys);
+
+    printResult(options_, trace_, TraceReplay<Map, T>{*map, trace_, options_.paced}.run());
+}
+
+template<typename T>
+void runEngine(const ReplayOptions& options_, const Trace& trace_)
+{
+    withEngine<T>(options_.engine, [&]<typename Map>(std::type_identity<Map>) { runReplay<Map, T>(options_, trace_); });
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto options = parseOptions(argc, argv);
+        const auto trace = loadTrace(options.trace);
+        if (options.valueSize == 0)
+            options.valueSize = traceValueSize(trace);
+
+        switch (options.valueSize)
+        {
+            case 8:    runEngine<int64_t>(options, trace);       break;
+            case 64:   runEngine<Payload<64>>(options, trace);   break;
+            case 256:  runEngine<Payload<256>>(options, trace);  break;
+            case 1024: runEngine<Payload<1024>>(options, trace); break;
+            case 4096: runEngine<Payload<4096>>(options, trace); break;
+            default:
+                throw std::invalid_argument("unsupported value size: " + std::to_string(options.valueSize));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "error: " << e.what() << "\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+
+// Standalone YCSB-style workload driver, to reproduce a production mix of
+// operations against any of the maps. e.g.:
+//
+//   GBY_SlotMap_WorkloadDriver --engine=optimizedLockedSlotMap --ratios=80:10:10:0
+//                              --distribution=latest --threads=8 --duration=10 --value-size=64
+//
+// With --record=PATH the run is also recorded as a trace, for GBY_SlotMap_TraceReplay.
+
+#include "Engines.h"
+#include "Trace.h"
+#include "Workload.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+void printUsage()
+{
+    std::cout << "Usage: GBY_SlotMap_WorkloadDriver [options]\n"
+              << "  --engine=NAME              one of:";
+    for (const auto* name : engineNames)
+        std::cout << " " << name;
+    std::cout << "\n"
+              << "  --ratios=R:I:E:T           relative weights of read/insert/erase/iterate (default 90:5:5:0)\n"
+              << "  --distribution=NAME        uniform, zipfian or latest (default zipfian)\n"
+              << "  --zipfian-skew=S           skew of the zipfian and latest distributions (default 0.99)\n"
+              << "  --threads=N                (default hardware concurrency)\n"
+              << "  --duration=SECONDS         (default 5)\n"
+              << "  --value-size=BYTES         8, 64, 256, 1024 or 4096 (default 8)\n"
+              << "  --records=N                elements inserted before the run (default 10000)\n"
+              << "  --record=PATH              record the run into a trace file\n";
+}
+
+KeyDistribution parseDistribution(const std::string& name_)
+{
+    if (name_ == "uniform") return KeyDistribution::Uniform;
+    if (name_ == "zipfian") return KeyDistribution::Zipfian;
+    if (name_ == "latest")  return KeyDistribution::Latest;
+    throw std::invalid_argument("unknown key distribution: " + name_);
+}
+
+const char* distributionName(const KeyDistribution distribution_)
+{
+    switch (distribution_)
+    {
+        case KeyDistribution::Uniform: return "uniform";
+        case KeyDistribution::Zipfian: return "zipfian";
+        case KeyDistribution::Latest:  return "latest";
+    }
+    return "";
+}
+
+std::array<double, 4> parseRatios(const std::string& ratios_)
+{
+    std::array<double, 4> ratios {};
+    std::istringstream ss {ratios_};
+    std::string ratio;
+    for (auto& r : ratios)
+    {
+        if (!std::getline(ss, ratio, ':'))
+            throw std::invalid_argument("expected 4 ratios (read:insert:erase:iterate), got: " + ratios_);
+        r = std::stod(ratio);
+        if (r < 0)
+            throw std::invalid_argument("ratios can't be negative: " + ratios_);
+    }
+    return ratios;
+}
+
+WorkloadOptions parseOptions(int argc, char** argv)
+{
+    WorkloadOptions options {};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg {argv[i]};
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(EXIT_SUCCESS);
+        }
+
+        const auto eq = arg.find('=');
+        if (!arg.starts_with("--") || eq == std::string_view::npos)
+            throw std::invalid_argument("expected --option=value, got: " + std::string{arg});
+
+        const std::string_view name  = arg.substr(2, eq - 2);
+        const std::string      value {arg.substr(eq + 1)};
+        if      (name == "engine")        options.engine       = value;
+        else if (name == "ratios")        options.ratios       = parseRatios(value);
+        else if (name == "distribution")  options.distribution = parseDistribution(value);
+        else if (name == "zipfian-skew")  options.zipfianSkew  = std::stod(value);
+        else if (name == "threads")       options.threads      = std::stoul(value);
+        else if (name == "duration")      options.duration     = std::stod(value);
+        else if (name == "value-size")    options.valueSize    = std::stoul(value);
+        else if (name == "records")       options.records      = std::stoul(value);
+        else if (name == "record")        options.record       = value;
+        else
+            throw std::invalid_argument("unknown option: " + std::string{arg});
+    }
+
+    if (options.threads == 0)
+        throw std::invalid_argument("threads has to be positive");
+    if (!(options.zipfianSkew > 0) || options.zipfianSkew == 1)
+        throw std::invalid_argument("zipfian-skew has to be positive and other than 1");
+    return options;
+}
+
+void printResult(const WorkloadOptions& options_, const WorkloadResult& result_)
+{
+    const double seconds = std::chrono::duration<double>(result_.elapsed).count();
+
+    std::cout << "engine: "       << options_.engine
+              << ", threads: "      << options_.threads
+              << ", distribution: " << distributionName(options_.distribution)
+              << ", value size: "   << options_.valueSize << "B"
+              << ", records: "      << options_.records   << "\n"
+              << "ran for " << seconds << "s, "
+              << static_cast<uint64_t>(result_.totalOperations() / seconds) << " ops/s\n\n";
+
+    printOperations(std::cout, result_);
+}
+
+template<typename Map, typename T>
+void runWorkload(const WorkloadOptions& options_)
+{
+    auto map = std::make_unique<Map>();
+    if constexpr (requires { map->reserve(options_.records); })
+        map->reserve(options_.records);
+
+    if (options_.record.empty())
+    {
+        printResult(options_, Workload<Map, T>{*map, options_}.run());
+        return;
+    }
+
+    TraceRecorder<Map> recorder {*map};
+    printResult(options_, Workload<TraceRecorder<Map>, T>{recorder, options_}.run());
+
+    const auto trace = recorder.trace();
+    saveTrace(options_.record, trace);
+    std::cout << "\nrecorded " << trace.records.size() << " operations of " << trace.threads
+              << " threads into " << options_.record << "\n";
+}
+
+template<typename T>
+void runEngine(const WorkloadOptions& options_)
+{
+    withEngine<T>(options_.engine, [&]<typename Map>(std::type_identity<Map>) { runWorkload<Map, T>(options_); });
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const auto options = parseOptions(argc, argv);
+        switch (options.valueSize)
+        {
+            case 8:    runEngine<int64_t>(options);       break;
+            case 64:   runEngine<Payload<64>>(options);   break;
+            case 256:  runEngine<Payload<256>>(options);  break;
+            case 1024: runEngine<Payload<1024>>(options); break;
+            case 4096: runEngine<Payload<4096>>(options); break;
+            default:
+                throw std::invalid_argument("unsupported value size: " + std::to_string(options.valueSize));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "error: " << e.what() << "\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}